@@ -1,149 +1,328 @@
-/**====================================================
- * @author      : Romain BESSON
- * @description : Random Instance Benchmarking
- *=====================================================**/
-
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <string>
-#include <iomanip>
-#include <limits>
-#include <cmath>
-#include <random>
-#include <map>
-
-#include "../cxxopts.hpp"     // CXXOpts for argument parsing
-#include "instance_gen.h"	  // 2D SPP Instance Generator
-#include "../packer/packer.h" // 2D Packing Library
-
-void print_args(uint32_t iterations, uint32_t N, float ratio, const std::string &output_file, bool verbose, uint32_t width, bool rotations, Heuristic strategy)
-{
-	std::cout << "\nBenching with:\n";
-	std::cout << "> Iteration Count:    " << iterations << "\n";
-	std::cout << "> Rectangle Count:    " << N << "\n";
-	std::cout << "> Ratio Height/Width: " << ratio << "\n";
-	std::cout << "> Strip Width:        " << width << "\n";
-	std::cout << "> Rotations Allowed:  " << (rotations ? "Yes" : "No") << "\n";
-	std::cout << "> Solve Strategy:     " << HeuristicStrings.at(strategy) << "\n";
-	std::cout << "> Output File:        " << (output_file.empty() ? "None" : output_file) << "\n";
-	std::cout << "> Verbose:            " << (verbose ? "Yes" : "No") << "\n\n";
-}
-
-// Round to specified number of decimal digits
-double keep_digits(double value, uint32_t digits)
-{
-	double precision = std::pow(10.0, digits);
-	return std::round(value * precision) / precision;
-}
-
-int main(int argc, char *argv[])
-{
-	cxxopts::Options options("bench", "A 2D SPP benchmark tool for randomly generated instances.");
-
-	options.add_options()
-		("h,help", "Print usage information")
-		("o,output", "Optional CSV file to save results", cxxopts::value<std::string>())
-		("v,verbose", "Show progress for each iteration", cxxopts::value<bool>()->default_value("false"))
-		("w,width", "Width of the strip for packing", cxxopts::value<uint32_t>()->default_value("10000"))
-		("r,rotate", "Allow rectangles to be rotated during packing", cxxopts::value<bool>()->default_value("false"))
-		("s,strategy", "Heuristic for sorting rectangles (0-3) (Desc. Area | Desc. Area 2 | Desc Width | Desc Height)", cxxopts::value<int>()->default_value("3"))
-		("iterations", "Number of benchmark iterations to run", cxxopts::value<uint32_t>())
-		("rects", "Number of rectangles per instance", cxxopts::value<uint32_t>())
-		("ratio", "Height/width ratio for the initial area", cxxopts::value<float>());
-	options.positional_help("<iterations> <rects> <ratio>");
-	options.parse_positional({"iterations", "rects", "ratio"});
-	
-	cxxopts::ParseResult result;
-	try {
-		result = options.parse(argc, argv);
-	} catch (const cxxopts::exceptions::exception& e) {
-		std::cerr << "Error parsing options: " << e.what() << std::endl;
-		std::cerr << options.help() << std::endl;
-		return EXIT_FAILURE;
-	}
-	if (result.count("help")) {
-		std::cout << options.help() << std::endl;
-		return EXIT_SUCCESS;
-	}
-	if (result.count("iterations") == 0 || result.count("rects") == 0 || result.count("ratio") == 0) {
-		std::cerr << "Error: Missing required arguments <iterations>, <rects>, and <ratio>.\n";
-		std::cout << options.help() << std::endl;
-		return EXIT_FAILURE;
-	}
-
-	// Get arguments from parsed results
-	uint32_t iterations = result["iterations"].as<uint32_t>();
-	uint32_t N = result["rects"].as<uint32_t>();
-	float ratio = result["ratio"].as<float>();
-	bool verbose = result["verbose"].as<bool>();
-	uint32_t width = result["width"].as<uint32_t>();
-	bool rotations = result["rotate"].as<bool>();
-	auto strategy = static_cast<Heuristic>(std::clamp(result["strategy"].as<int>(), 0, static_cast<int>(Heuristic::Count)-1));
-	std::string output_file = result.count("output") ? result["output"].as<std::string>() : "";
-
-	// Post-parsing validation
-	if (iterations == 0) {
-		std::cerr << "Error: Iteration count must be greater than 0.\n";
-		return EXIT_FAILURE;
-	}
-	if (ratio <= 0) {
-		std::cerr << "Error: Ratio must be a positive number.\n";
-		return EXIT_FAILURE;
-	}
-
-	print_args(iterations, N, ratio, output_file, verbose, width, rotations, strategy);
-
-	double best = std::numeric_limits<double>::infinity();
-	double worst = -std::numeric_limits<double>::infinity();
-	double sum = 0.0;
-
-	if (verbose)
-		std::cout << "Starting benchmark...\n";
-
-	std::random_device seeder;
-	std::mt19937 engine(seeder());
-
-	std::ofstream ofs;
-	if (!output_file.empty()) {
-		ofs.open(output_file);
-		if (!ofs.is_open()) {
-			std::cerr << "Error: Cannot open file '" << output_file << "' for writing.\n";
-			return EXIT_FAILURE;
-		}
-		ofs << "#IT,H,OPT_H,H_div_OPT_H\n"; // CSV header
-	}
-
-	for (uint32_t i = 1; i <= iterations; ++i) {
-		std::vector<Shape> rectangles = gen_instance(width, N, ratio, engine);
-		Result pack_result = solve(width, rectangles, rotations, strategy, false);
-
-		const double expected_h = static_cast<double>(width) * ratio;
-		const double alpha = keep_digits(static_cast<double>(pack_result.h) / expected_h, 4);
-
-		best = std::min(best, alpha);
-		worst = std::max(worst, alpha);
-		sum += alpha;
-
-		if (verbose)
-			std::cout << "IT " << std::setw(4) << i << "/" << iterations
-					  << " -> H=" << std::setw(6) << pack_result.h
-					  << ", Ratio=" << std::fixed << std::setprecision(4) << alpha << "\n";
-
-		if (ofs.is_open())
-			ofs << i << ',' << pack_result.h << ',' << static_cast<uint32_t>(expected_h) << ',' << alpha << '\n';
-	}
-
-	const double average = sum / iterations;
-
-	std::cout << "\nDone!\n";
-	std::cout << "Worst Ratio: " << worst << "\n";
-	std::cout << "Best Ratio:  " << best << "\n";
-	std::cout << "Avg Ratio:   " << average << "\n";
-
-	if (ofs.is_open()) {
-		ofs << "Summary: worst=" << worst << ",best=" << best << ",avg=" << average << '\n';
-	}
-
-	return EXIT_SUCCESS;
-}
\ No newline at end of file
+/**====================================================
+ * @author      : Romain BESSON
+ * @description : Random Instance Benchmarking
+ *=====================================================**/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <limits>
+#include <cmath>
+#include <random>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+
+#include "../cxxopts.hpp"     // CXXOpts for argument parsing
+#include "instance_gen.h"	  // 2D SPP Instance Generator
+#include "../packer/packer.h" // 2D Packing Library
+#include "../packer/thread_pool.h"
+
+void print_args(uint32_t iterations, uint32_t N, float ratio, const std::string &output_file, bool verbose, uint32_t width, bool rotations, Heuristic strategy, uint64_t seed, size_t threads)
+{
+	std::cout << "\nBenching with:\n";
+	std::cout << "> Iteration Count:    " << iterations << "\n";
+	std::cout << "> Rectangle Count:    " << N << "\n";
+	std::cout << "> Ratio Height/Width: " << ratio << "\n";
+	std::cout << "> Strip Width:        " << width << "\n";
+	std::cout << "> Rotations Allowed:  " << (rotations ? "Yes" : "No") << "\n";
+	std::cout << "> Solve Strategy:     " << HeuristicStrings.at(strategy) << "\n";
+	std::cout << "> Seed:               " << seed << "\n";
+	std::cout << "> Threads:            " << threads << "\n";
+	std::cout << "> Output File:        " << (output_file.empty() ? "None" : output_file) << "\n";
+	std::cout << "> Verbose:            " << (verbose ? "Yes" : "No") << "\n\n";
+}
+
+template <typename T>
+std::string join(const std::vector<T> &values)
+{
+	std::ostringstream oss;
+	for (size_t i = 0; i < values.size(); ++i)
+		oss << (i ? ", " : "") << values[i];
+	return oss.str();
+}
+
+void print_grid_args(uint32_t iterations, const std::vector<uint32_t> &Ns, const std::vector<float> &ratios, const std::string &output_dir, bool verbose, uint32_t width, bool rotations, Heuristic strategy, uint64_t seed, size_t threads)
+{
+	std::cout << "\nBenching a grid with:\n";
+	std::cout << "> Iteration Count:    " << iterations << " per cell\n";
+	std::cout << "> Rectangle Counts:   " << join(Ns) << "\n";
+	std::cout << "> Ratios H/W:         " << join(ratios) << "\n";
+	std::cout << "> Strip Width:        " << width << "\n";
+	std::cout << "> Rotations Allowed:  " << (rotations ? "Yes" : "No") << "\n";
+	std::cout << "> Solve Strategy:     " << HeuristicStrings.at(strategy) << "\n";
+	std::cout << "> Seed:               " << seed << "\n";
+	std::cout << "> Threads:            " << threads << "\n";
+	std::cout << "> Output Folder:      " << (output_dir.empty() ? "None" : output_dir) << "\n";
+	std::cout << "> Verbose:            " << (verbose ? "Yes" : "No") << "\n\n";
+}
+
+// Round to specified number of decimal digits
+double keep_digits(double value, uint32_t digits)
+{
+	double precision = std::pow(10.0, digits);
+	return std::round(value * precision) / precision;
+}
+
+// Iteration i's own random stream, the same whichever thread runs it
+std::mt19937 iteration_engine(uint64_t seed, uint32_t i)
+{
+	std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), i};
+	return std::mt19937(seq);
+}
+
+/**============================================
+ *                   Cell
+ * Every iteration of one (N, ratio) pair, what
+ * a single bench run measures
+ *=============================================**/
+struct Cell {
+	uint32_t N;
+	float ratio;
+	std::vector<uint32_t> heights{}; // By iteration
+	double worst = 0.0, best = 0.0, average = 0.0;
+};
+
+double expected_height(uint32_t width, float ratio)
+{
+	return static_cast<double>(width) * ratio;
+}
+
+// Runs every iteration of every cell on pool. Workers take jobs from one list, largest N
+// first, so the longest jobs start early and the short ones fill in the gaps at the end.
+// Iteration i of a cell uses iteration_engine(seed, i), like a single bench run of that cell
+void run_cells(std::vector<Cell> &cells, uint32_t iterations, uint32_t width, bool rotations, Heuristic strategy, uint64_t seed, ThreadPool &pool, bool verbose)
+{
+	std::vector<std::pair<uint32_t, uint32_t>> jobs; // (cell, iteration)
+	for (uint32_t c = 0; c < cells.size(); ++c) {
+		cells[c].heights.assign(iterations, 0);
+		for (uint32_t i = 1; i <= iterations; ++i)
+			jobs.emplace_back(c, i);
+	}
+	std::stable_sort(jobs.begin(), jobs.end(), [&cells](const auto &a, const auto &b) { return cells[a.first].N > cells[b.first].N; });
+
+	std::atomic<size_t> next_job{0};
+	std::mutex print_mutex;
+
+	for (size_t t = 0; t < pool.size(); ++t) {
+		pool.submit([&]() {
+			Solver solver;
+			Result result;
+			for (size_t j = next_job++; j < jobs.size(); j = next_job++) {
+				Cell &cell = cells[jobs[j].first];
+				uint32_t i = jobs[j].second;
+				std::mt19937 engine = iteration_engine(seed, i);
+				std::vector<Shape> rectangles = gen_instance(width, cell.N, cell.ratio, engine);
+				// Only heights are reported, the solve is given no lower bound to compute
+				solver.solve(result, width, rectangles, rotations, strategy, false);
+				cell.heights[i - 1] = result.h;
+
+				if (verbose) {
+					std::lock_guard<std::mutex> lock(print_mutex);
+					if (cells.size() > 1)
+						std::cout << "N=" << std::setw(5) << cell.N << " H/W=" << std::setw(4) << cell.ratio << " ";
+					std::cout << "IT " << std::setw(4) << i << "/" << iterations
+							  << " -> H=" << std::setw(6) << cell.heights[i - 1]
+							  << ", Ratio=" << std::fixed << std::setprecision(4) << keep_digits(static_cast<double>(cell.heights[i - 1]) / expected_height(width, cell.ratio), 4) << std::defaultfloat << "\n";
+				}
+			}
+		});
+	}
+	pool.wait();
+
+	// Stats in iteration order, so they don't depend on the thread count
+	for (Cell &cell : cells) {
+		double sum = 0.0;
+		cell.best = std::numeric_limits<double>::infinity();
+		cell.worst = -std::numeric_limits<double>::infinity();
+		for (uint32_t height : cell.heights) {
+			const double alpha = keep_digits(static_cast<double>(height) / expected_height(width, cell.ratio), 4);
+			cell.best = std::min(cell.best, alpha);
+			cell.worst = std::max(cell.worst, alpha);
+			sum += alpha;
+		}
+		cell.average = sum / iterations;
+	}
+}
+
+// A line per iteration, then the summary
+void write_cell(std::ostream &os, const Cell &cell, uint32_t width)
+{
+	const double expected_h = expected_height(width, cell.ratio);
+	os << "#IT,H,OPT_H,H_div_OPT_H\n"; // CSV header
+	for (uint32_t i = 1; i <= cell.heights.size(); ++i)
+		os << i << ',' << cell.heights[i - 1] << ',' << static_cast<uint32_t>(expected_h) << ',' << keep_digits(static_cast<double>(cell.heights[i - 1]) / expected_h, 4) << '\n';
+	os << "Summary: worst=" << cell.worst << ",best=" << cell.best << ",avg=" << cell.average << '\n';
+}
+
+// The runs/ summary layout, which runs/visualize.py plots
+bool write_grid_summary(const std::filesystem::path &path, const std::vector<Cell> &cells, double Cell::*stat)
+{
+	std::ofstream ofs(path);
+	if (!ofs.is_open())
+		return false;
+	ofs << "N,H/W,H/OPTH\n";
+	for (const Cell &cell : cells)
+		ofs << cell.N << ',' << cell.ratio << ',' << cell.*stat << '\n';
+	return true;
+}
+
+void print_grid(const std::vector<Cell> &cells, const std::vector<uint32_t> &Ns, const std::vector<float> &ratios, const char *name, double Cell::*stat)
+{
+	std::cout << '\n' << name << " Ratio:\n" << std::setw(8) << "N \\ H/W";
+	for (float ratio : ratios)
+		std::cout << std::setw(9) << ratio;
+	std::cout << '\n' << std::fixed << std::setprecision(4);
+	for (size_t n = 0; n < Ns.size(); ++n) {
+		std::cout << std::setw(8) << Ns[n];
+		for (size_t r = 0; r < ratios.size(); ++r)
+			std::cout << std::setw(9) << cells[n * ratios.size() + r].*stat;
+		std::cout << '\n';
+	}
+	std::cout << std::defaultfloat;
+}
+
+int main(int argc, char *argv[])
+{
+	cxxopts::Options options("bench", "A 2D SPP benchmark tool for randomly generated instances.");
+
+	options.add_options()
+		("h,help", "Print usage information")
+		("o,output", "Optional CSV file to save results (with --grid, folder for a CSV per cell and the summaries)", cxxopts::value<std::string>())
+		("v,verbose", "Show progress for each iteration", cxxopts::value<bool>()->default_value("false"))
+		("w,width", "Width of the strip for packing", cxxopts::value<uint32_t>()->default_value("10000"))
+		("r,rotate", "Allow rectangles to be rotated during packing", cxxopts::value<bool>()->default_value("false"))
+		("s,strategy", "Heuristic for sorting rectangles (0-3) (Desc. Area | Desc. Area 2 | Desc Width | Desc Height)", cxxopts::value<int>()->default_value("3"))
+		("seed", "Master seed, each iteration's instance derives from it and the iteration number (random if not set)", cxxopts::value<uint64_t>())
+		("t,threads", "Number of worker threads (0 = one per hardware thread)", cxxopts::value<size_t>()->default_value("0"))
+		("grid", "Bench every pair of these rectangle counts and --grid-ratios at once, instead of <rects> <ratio> (e.g. 5,50,100)", cxxopts::value<std::vector<uint32_t>>())
+		("grid-ratios", "Height/width ratios of the grid", cxxopts::value<std::vector<float>>()->default_value("0.1,0.2,0.5,1,2,5,10"))
+		("iterations", "Number of benchmark iterations to run", cxxopts::value<uint32_t>())
+		("rects", "Number of rectangles per instance", cxxopts::value<uint32_t>())
+		("ratio", "Height/width ratio for the initial area", cxxopts::value<float>());
+	options.positional_help("<iterations> <rects> <ratio>");
+	options.parse_positional({"iterations", "rects", "ratio"});
+	
+	cxxopts::ParseResult result;
+	try {
+		result = options.parse(argc, argv);
+	} catch (const cxxopts::exceptions::exception& e) {
+		std::cerr << "Error parsing options: " << e.what() << std::endl;
+		std::cerr << options.help() << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (result.count("help")) {
+		std::cout << options.help() << std::endl;
+		return EXIT_SUCCESS;
+	}
+	bool grid = result.count("grid") != 0;
+	if (result.count("iterations") == 0 || (!grid && (result.count("rects") == 0 || result.count("ratio") == 0))) {
+		std::cerr << "Error: Missing required arguments <iterations>, <rects>, and <ratio> (or <iterations> and --grid).\n";
+		std::cout << options.help() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Get arguments from parsed results
+	uint32_t iterations = result["iterations"].as<uint32_t>();
+	std::vector<uint32_t> Ns = grid ? result["grid"].as<std::vector<uint32_t>>() : std::vector<uint32_t>{result["rects"].as<uint32_t>()};
+	std::vector<float> ratios = grid ? result["grid-ratios"].as<std::vector<float>>() : std::vector<float>{result["ratio"].as<float>()};
+	bool verbose = result["verbose"].as<bool>();
+	uint32_t width = result["width"].as<uint32_t>();
+	bool rotations = result["rotate"].as<bool>();
+	auto strategy = static_cast<Heuristic>(std::clamp(result["strategy"].as<int>(), 0, static_cast<int>(Heuristic::Count)-1));
+	std::string output_file = result.count("output") ? result["output"].as<std::string>() : "";
+	uint64_t seed = result.count("seed") ? result["seed"].as<uint64_t>() : (uint64_t(std::random_device{}()) << 32 | std::random_device{}());
+	size_t threads = result["threads"].as<size_t>();
+
+	// Post-parsing validation
+	if (iterations == 0) {
+		std::cerr << "Error: Iteration count must be greater than 0.\n";
+		return EXIT_FAILURE;
+	}
+	if (Ns.empty() || ratios.empty()) {
+		std::cerr << "Error: The grid needs at least one rectangle count and one ratio.\n";
+		return EXIT_FAILURE;
+	}
+	if (std::any_of(ratios.begin(), ratios.end(), [](float ratio) { return ratio <= 0; })) {
+		std::cerr << "Error: Ratio must be a positive number.\n";
+		return EXIT_FAILURE;
+	}
+
+	ThreadPool pool(threads);
+	if (grid)
+		print_grid_args(iterations, Ns, ratios, output_file, verbose, width, rotations, strategy, seed, pool.size());
+	else
+		print_args(iterations, Ns[0], ratios[0], output_file, verbose, width, rotations, strategy, seed, pool.size());
+
+	std::ofstream ofs;
+	if (!output_file.empty()) {
+		if (grid) {
+			std::error_code error;
+			std::filesystem::create_directories(output_file, error);
+			if (!std::filesystem::is_directory(output_file)) {
+				std::cerr << "Error: Cannot create folder '" << output_file << "'.\n";
+				return EXIT_FAILURE;
+			}
+		} else {
+			ofs.open(output_file);
+			if (!ofs.is_open()) {
+				std::cerr << "Error: Cannot open file '" << output_file << "' for writing.\n";
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	if (verbose)
+		std::cout << "Starting benchmark...\n";
+
+	// Cells by N, then ratio
+	std::vector<Cell> cells;
+	for (uint32_t N : Ns)
+		for (float ratio : ratios)
+			cells.push_back(Cell{N, ratio});
+
+	auto start = std::chrono::high_resolution_clock::now();
+	run_cells(cells, iterations, width, rotations, strategy, seed, pool, verbose);
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::cout << "\nDone!\n";
+	if (!grid) {
+		std::cout << "Worst Ratio: " << cells[0].worst << "\n";
+		std::cout << "Best Ratio:  " << cells[0].best << "\n";
+		std::cout << "Avg Ratio:   " << cells[0].average << "\n";
+
+		if (ofs.is_open())
+			write_cell(ofs, cells[0], width);
+		return EXIT_SUCCESS;
+	}
+
+	std::cout << cells.size() << " cells took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+	print_grid(cells, Ns, ratios, "Worst", &Cell::worst);
+	print_grid(cells, Ns, ratios, "Avg", &Cell::average);
+
+	// Same file names as single runs, which runs/summarize.py reads
+	if (!output_file.empty()) {
+		for (const Cell &cell : cells) {
+			std::ostringstream name;
+			name << 'N' << cell.N << "_IT" << iterations << "_WH" << cell.ratio << ".csv";
+			std::ofstream cell_ofs(std::filesystem::path(output_file) / name.str());
+			if (!cell_ofs.is_open()) {
+				std::cerr << "Error: Cannot open file '" << name.str() << "' for writing.\n";
+				return EXIT_FAILURE;
+			}
+			write_cell(cell_ofs, cell, width);
+		}
+		if (!write_grid_summary(std::filesystem::path(output_file) / "summary_results.csv", cells, &Cell::average) ||
+			!write_grid_summary(std::filesystem::path(output_file) / "summary_results_worst.csv", cells, &Cell::worst)) {
+			std::cerr << "Error: Cannot write the summaries to '" << output_file << "'.\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
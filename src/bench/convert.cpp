@@ -0,0 +1,76 @@
+/**====================================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Converts text instances to the
+ *                binary instance format
+ *=====================================================**/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "../cxxopts.hpp"
+#include "../packer/loader.h"
+#include "../packer/thread_pool.h"
+
+int main(int argc, char *argv[])
+{
+	cxxopts::Options options("convert", "Converts text instances to binary instances (<name>.bin next to each input, <name>_<problem>.bin for each problem of an OR-Lib file).");
+
+	options.add_options()
+		("h,help", "Print usage information")
+		("w,width", "Width of inputs that don't give one", cxxopts::value<uint32_t>()->default_value("0"))
+		("known-height", "Optimal height to store for inputs that don't give one, 0 if unknown", cxxopts::value<uint32_t>()->default_value("0"))
+		("inputs", "Text instance files", cxxopts::value<std::vector<std::string>>());
+	options.positional_help("<input files...>");
+	options.parse_positional({"inputs"});
+
+	cxxopts::ParseResult result;
+	try {
+		result = options.parse(argc, argv);
+	} catch (const cxxopts::exceptions::exception& e) {
+		std::cerr << "Error parsing options: " << e.what() << std::endl;
+		std::cerr << options.help() << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (result.count("help")) {
+		std::cout << options.help() << std::endl;
+		return EXIT_SUCCESS;
+	}
+	if (result.count("inputs") == 0) {
+		std::cerr << "Error: Missing required argument <input files...>.\n";
+		std::cout << options.help() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	uint32_t default_width = result["width"].as<uint32_t>();
+	uint32_t known_h = result["known-height"].as<uint32_t>();
+
+	ThreadPool pool{};
+	int failed = 0;
+	for (const std::string &input : result["inputs"].as<std::vector<std::string>>()) {
+		try {
+			for (const Instance &instance : load_instances(input, &pool)) {
+				std::filesystem::path output = std::filesystem::path(input).replace_extension(".bin");
+				if (instance.problem != 0)
+					output.replace_filename(output.stem().string() + "_" + std::to_string(instance.problem) + ".bin");
+				uint32_t W = instance.W != 0 ? instance.W : default_width;
+				if (W == 0)
+					throw std::runtime_error("it gives no width and no --width was given");
+
+				std::ofstream ofs(output, std::ios::binary);
+				if (!ofs.is_open())
+					throw std::runtime_error("cannot open '" + output.string() + "' for writing");
+				write_binary_instance(ofs, W, instance.rectangles, instance.known_h != 0 ? instance.known_h : known_h);
+				std::cout << input << " -> " << output.string() << " (W=" << W << ", N=" << instance.rectangles.size() << ")\n";
+			}
+		} catch (const std::exception &e) {
+			std::cerr << "Error: " << input << ": " << e.what() << '\n';
+			failed++;
+		}
+	}
+
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -12,6 +12,7 @@
 
 #include "../cxxopts.hpp"
 #include "instance_gen.h"
+#include "../packer/loader.h"
 
 void print_args(uint32_t W, uint32_t N, float height_width_ratio, const std::string& output_file)
 {
@@ -31,6 +32,7 @@ int main(int argc, char *argv[])
 		("width", "The width of the main container", cxxopts::value<uint32_t>())
 		("rects", "The number of rectangles to generate", cxxopts::value<uint32_t>())
 		("ratio", "The height/width ratio for the initial rectangle area", cxxopts::value<float>())
+		("b,binary", "Write a binary instance, with W and the optimal height in its header", cxxopts::value<bool>()->default_value("false"))
 		("output", "The path to the output file", cxxopts::value<std::string>());
 	options.positional_help("<width> <rects> <ratio> <output>");
 	options.parse_positional({"width", "rects", "ratio", "output"});
@@ -58,6 +60,7 @@ int main(int argc, char *argv[])
 	uint32_t N = result["rects"].as<uint32_t>();
 	float height_width_ratio = result["ratio"].as<float>();
 	std::string output_file = result["output"].as<std::string>();
+	bool binary = result["binary"].as<bool>();
 
 	// Post-parsing validation
 	if (W == 0) {
@@ -80,15 +83,23 @@ int main(int argc, char *argv[])
 	std::mt19937 engine(seeder());
 	std::vector<Shape> rectangles = gen_instance(W, N, height_width_ratio, engine);
 
-	std::ofstream ofs(output_file);
+	std::ofstream ofs(output_file, binary ? std::ios::binary : std::ios::out);
 	if (!ofs.is_open())
 	{
 		std::cerr << "Error: Cannot open file '" << output_file << "' for writing.\n";
 		return EXIT_FAILURE;
 	}
 	
-	for (const Shape &rectangle : rectangles) {
-		ofs << rectangle.w() << ' ' << rectangle.h() << '\n';
+	if (binary) {
+		// The rectangles tile a W wide strip, so area / W is the optimal height
+		uint64_t total_area = 0;
+		for (const Shape &rectangle : rectangles)
+			total_area += rectangle.area();
+		write_binary_instance(ofs, W, rectangles, static_cast<uint32_t>(total_area / W));
+	} else {
+		for (const Shape &rectangle : rectangles) {
+			ofs << rectangle.w() << ' ' << rectangle.h() << '\n';
+		}
 	}
 	
 	std::cout << "\nSuccessfully generated " << rectangles.size() << " rectangles to '" << output_file << "'\n";
@@ -0,0 +1,49 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Block arena for the solver's
+ *                node-based containers
+ *=============================================**/
+
+#include <new>
+
+#include "arena.h"
+
+void *Arena::allocate(size_t size)
+{
+	size_t size_class = (size + ALIGN - 1) / ALIGN;
+	if (size_class == 0 || size_class > SIZE_CLASSES)
+		return ::operator new(size);
+
+	FreeBlock *&free = free_[size_class - 1];
+	if (free)
+	{
+		FreeBlock *block = free;
+		free = block->next;
+		return block;
+	}
+
+	size_t bytes = size_class * ALIGN;
+	if (chunk_used_ + bytes > CHUNK_SIZE)
+	{
+		chunks_.emplace_back(new unsigned char[CHUNK_SIZE]);
+		chunk_used_ = 0;
+	}
+	void *block = chunks_.back().get() + chunk_used_;
+	chunk_used_ += bytes;
+	return block;
+}
+
+void Arena::deallocate(void *block, size_t size)
+{
+	size_t size_class = (size + ALIGN - 1) / ALIGN;
+	if (size_class == 0 || size_class > SIZE_CLASSES)
+	{
+		::operator delete(block);
+		return;
+	}
+
+	FreeBlock *free = static_cast<FreeBlock *>(block);
+	free->next = free_[size_class - 1];
+	free_[size_class - 1] = free;
+}
@@ -0,0 +1,92 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Block arena for the solver's
+ *                node-based containers
+ *=============================================**/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory>
+#include <cstddef>
+
+#include "../types.h"
+
+/**============================================
+ *                   Arena
+ * Hands out small blocks carved from large
+ * chunks and keeps freed blocks in free lists
+ * by size, so hash map and tree nodes are reused
+ * instead of going back to the heap. Memory is
+ * only released when the arena is destroyed.
+ * Not thread safe.
+ *=============================================**/
+class Arena
+{
+public:
+	static constexpr size_t ALIGN = alignof(std::max_align_t);
+
+	Arena() = default;
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	void *allocate(size_t size);
+	void deallocate(void *block, size_t size);
+
+private:
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+	static constexpr size_t SIZE_CLASSES = 8; // Blocks up to SIZE_CLASSES * ALIGN bytes, larger ones use the heap
+
+	struct FreeBlock
+	{
+		FreeBlock *next;
+	};
+
+	std::vector<std::unique_ptr<unsigned char[]>> chunks_{};
+	size_t chunk_used_ = CHUNK_SIZE;
+	FreeBlock *free_[SIZE_CLASSES] = {};
+};
+
+/**============================================
+ *               ArenaAllocator
+ * Allocator for standard containers: single
+ * elements (nodes) come from the arena, arrays
+ * (hash buckets) from the heap.
+ *=============================================**/
+template <typename T>
+struct ArenaAllocator
+{
+	static_assert(alignof(T) <= Arena::ALIGN, "ArenaAllocator: over-aligned type");
+
+	using value_type = T;
+
+	Arena *arena;
+
+	explicit ArenaAllocator(Arena &arena) : arena(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+	T *allocate(size_t n)
+	{
+		if (n == 1)
+			return static_cast<T *>(arena->allocate(sizeof(T)));
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T *p, size_t n)
+	{
+		if (n == 1)
+			arena->deallocate(p, sizeof(T));
+		else
+			std::allocator<T>().deallocate(p, n);
+	}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+};
+
+#endif
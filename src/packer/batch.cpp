@@ -0,0 +1,336 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Solves many instance files in
+ *                one parse/solve/write pipeline
+ *=============================================**/
+
+#include <map>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+
+#include "batch.h"
+#include "packer.h"
+#include "loader.h"
+#include "lower_bound.h"
+#include "result_writer.h"
+#include "bounded_queue.h"
+
+constexpr size_t ITEMS_PER_SOLVER = 2; // Instances each queue holds per solver thread
+
+// A file on its way through the pipeline
+struct BatchItem
+{
+	size_t index = 0; // In the input order
+	BatchEntry entry{};
+	std::vector<Shape> rectangles{};
+};
+
+// Adds file's instances to paths, or file itself if it can't be read, for solve_batch to report
+static void add_instances(std::vector<std::string> &paths, const std::string &file)
+{
+	try
+	{
+		std::vector<std::string> instances = instance_paths(file);
+		paths.insert(paths.end(), instances.begin(), instances.end());
+	}
+	catch (const std::exception &)
+	{
+		paths.push_back(file);
+	}
+}
+
+std::vector<std::string> list_instances(const std::string &source)
+{
+	std::vector<std::string> paths;
+	if (std::filesystem::is_directory(source))
+	{
+		std::vector<std::string> files;
+		for (const auto &file : std::filesystem::recursive_directory_iterator(source))
+		{
+			std::string extension = file.path().extension().string();
+			if (file.is_regular_file() && (extension == ".txt" || extension == ".lst" || extension == ".bin"))
+				files.push_back(file.path().string());
+		}
+		std::sort(files.begin(), files.end());
+		for (const std::string &file : files)
+		{
+			add_instances(paths, file);
+		}
+		return paths;
+	}
+
+	std::ifstream list(source);
+	if (!list.is_open())
+		throw std::runtime_error("Couldn't open " + source + ": " + std::strerror(errno));
+	std::string line;
+	while (std::getline(list, line))
+	{
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+		if (line.empty())
+			continue;
+		if (split_problem(line).second != 0)
+			paths.push_back(line);
+		else
+			add_instances(paths, line);
+	}
+	return paths;
+}
+
+// Reads item's file into it, or records why it can't
+static void parse(BatchItem &item, const BatchOptions &options)
+{
+	BatchEntry &entry = item.entry;
+	try
+	{
+		Instance instance = load_instance(entry.path);
+		entry.W = instance.W != 0 ? instance.W : options.W;
+		entry.N = instance.rectangles.size();
+		entry.known_h = instance.known_h;
+		item.rectangles = std::move(instance.rectangles);
+	}
+	catch (const std::exception &e)
+	{
+		entry.error = e.what();
+		return;
+	}
+	if (entry.W == 0)
+		entry.error = "The instance gives no width and no width was given";
+}
+
+static void solve_item(Solver &solver, BatchItem &item, const BatchOptions &options)
+{
+	BatchEntry &entry = item.entry;
+	if (!entry.error.empty())
+		return;
+	try
+	{
+		SolveCutoff cutoff{};
+		cutoff.lower_bound = height_lower_bound(entry.W, item.rectangles, options.rotations).value;
+		if (!options.all_heuristics)
+		{
+			entry.result = solver.solve(entry.W, item.rectangles, options.rotations, options.strategy, false, cutoff);
+		}
+		else
+		{
+			// Later heuristics stop once they can't beat the best one so far
+			std::vector<Result> results;
+			for (int s = 0; s < static_cast<int>(Heuristic::Count); ++s)
+			{
+				results.push_back(solver.solve(entry.W, item.rectangles, options.rotations, static_cast<Heuristic>(s), false, cutoff));
+				if (results.back().complete)
+					cutoff.max_height = std::min(cutoff.max_height, results.back().h);
+			}
+			entry.result = best_result(results);
+			entry.result.elapsed_ms = 0;
+			for (const Result &result : results)
+			{
+				entry.result.elapsed_ms += result.elapsed_ms;
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		entry.error = e.what();
+	}
+	item.rectangles.clear();
+	item.rectangles.shrink_to_fit();
+}
+
+// Directory of an instance file, absolute and without . or .. parts
+static std::filesystem::path instance_directory(const std::string &instance)
+{
+	return std::filesystem::absolute(split_problem(instance).first).lexically_normal().parent_path();
+}
+
+// Deepest directory holding every instance file
+static std::filesystem::path common_root(const std::vector<std::string> &files)
+{
+	std::filesystem::path root;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		std::filesystem::path directory = instance_directory(files[i]);
+		if (i == 0)
+		{
+			root = directory;
+			continue;
+		}
+		std::filesystem::path common;
+		for (auto a = root.begin(), b = directory.begin(); a != root.end() && b != directory.end() && *a == *b; ++a, ++b)
+		{
+			common /= *a;
+		}
+		root = common;
+	}
+	return root;
+}
+
+// <output_dir>/<instance's directories under root>/<instance name>[_<problem>]_result.csv, mirroring the corpus layout
+static std::filesystem::path result_path(const std::string &output_dir, const std::filesystem::path &root, const std::string &instance)
+{
+	auto [file, problem] = split_problem(instance);
+	std::string name = std::filesystem::path(file).stem().string() + (problem != 0 ? "_" + std::to_string(problem) : "");
+	std::filesystem::path directory = instance_directory(instance).lexically_relative(root);
+	return (std::filesystem::path(output_dir) / directory / (name + "_result.csv")).lexically_normal();
+}
+
+// field as a CSV field: quoted, its quotes doubled, if it holds a separator, a quote or a line break
+static std::string csv_field(const std::string &field)
+{
+	if (field.find_first_of(",\"\r\n") == std::string::npos)
+		return field;
+	std::string quoted = "\"";
+	for (char c : field)
+	{
+		quoted += c;
+		if (c == '"')
+			quoted += '"';
+	}
+	return quoted + '"';
+}
+
+// Writes <output_dir>/summary.csv, returns why it couldn't, empty on success
+static std::string write_summary(const std::string &output_dir, const BatchSummary &summary)
+{
+	std::filesystem::path path = std::filesystem::path(output_dir) / "summary.csv";
+	std::ofstream ofs(path);
+	if (!ofs.is_open())
+		return "Cannot open " + path.string() + " for writing";
+
+	ofs << "file,W,N,H,OPT(I),known_H,ratio,loss,ms,error" << '\n';
+	for (const BatchEntry &entry : summary.entries)
+	{
+		ofs << csv_field(entry.path) << ',' << entry.W << ',' << entry.N << ',';
+		if (entry.error.empty())
+		{
+			const Result &result = entry.result;
+			ofs << result.h << ',' << result.opt_h << ',';
+			if (entry.known_h != 0)
+				ofs << entry.known_h;
+			ofs << ',';
+			if (result.opt_h != 0)
+				ofs << static_cast<float>(result.h) / result.opt_h;
+			ofs << ',' << result.loss << '%' << ',' << result.elapsed_ms << ",\n";
+		}
+		else
+		{
+			ofs << ",,,,,," << csv_field(entry.error) << '\n';
+		}
+	}
+	ofs.close();
+	if (ofs.fail())
+		return "Cannot write " + path.string();
+	return "";
+}
+
+BatchSummary solve_batch(const std::vector<std::string> &files, const BatchOptions &options)
+{
+	auto start_time = std::chrono::high_resolution_clock::now();
+	size_t solvers = options.solvers != 0 ? options.solvers : std::max(1u, std::thread::hardware_concurrency());
+	size_t parsers = std::max<size_t>(1, std::min(options.parsers, files.size()));
+
+	BatchSummary summary{};
+	summary.entries.resize(files.size());
+
+	// Result files, an instance whose file is taken by an earlier one fails
+	std::vector<std::filesystem::path> result_paths(options.output_dir.empty() ? 0 : files.size());
+	std::vector<std::string> path_errors(files.size());
+	if (!options.output_dir.empty())
+	{
+		std::filesystem::path root = common_root(files);
+		std::map<std::filesystem::path, size_t> owners;
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			result_paths[i] = result_path(options.output_dir, root, files[i]);
+			auto [owner, added] = owners.emplace(result_paths[i], i);
+			if (!added)
+				path_errors[i] = "Its result file " + result_paths[i].string() + " is " + files[owner->second] + "'s";
+		}
+	}
+	BoundedQueue<BatchItem> parsed(ITEMS_PER_SOLVER * solvers);
+	BoundedQueue<BatchItem> solved(ITEMS_PER_SOLVER * solvers);
+
+	// Parsers claim files in order, so instances reach the solvers about in input order
+	std::atomic<size_t> next_file{0};
+	std::atomic<size_t> parsers_left{parsers};
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < parsers; ++t)
+	{
+		threads.emplace_back([&]()
+							 {
+			for (size_t i = next_file++; i < files.size(); i = next_file++)
+			{
+				BatchItem item{};
+				item.index = i;
+				item.entry.path = files[i];
+				item.entry.error = path_errors[i];
+				if (item.entry.error.empty())
+					parse(item, options);
+				parsed.push(std::move(item));
+			}
+			if (--parsers_left == 0)
+				parsed.close(); });
+	}
+
+	std::atomic<size_t> solvers_left{solvers};
+	for (size_t t = 0; t < solvers; ++t)
+	{
+		threads.emplace_back([&]()
+							 {
+			Solver solver;
+			while (std::optional<BatchItem> item = parsed.pop())
+			{
+				solve_item(solver, *item, options);
+				solved.push(std::move(*item));
+			}
+			if (--solvers_left == 0)
+				solved.close(); });
+	}
+
+	// The writer runs on this thread
+	while (std::optional<BatchItem> item = solved.pop())
+	{
+		BatchEntry &entry = item->entry;
+		if (entry.error.empty() && !options.output_dir.empty())
+		{
+			const std::filesystem::path &path = result_paths[item->index];
+			std::error_code error;
+			std::filesystem::create_directories(path.parent_path(), error);
+			try
+			{
+				ResultWriter writer(path.string());
+				writer.write(entry.result);
+				writer.close();
+			}
+			catch (const std::exception &e)
+			{
+				entry.error = e.what();
+			}
+		}
+		entry.result.rectangles.clear();
+		entry.result.rectangles.shrink_to_fit();
+		if (!entry.error.empty())
+			summary.failed++;
+		if (options.on_result)
+			options.on_result(entry);
+		summary.entries[item->index] = std::move(entry);
+	}
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+
+	if (!options.output_dir.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(options.output_dir, error);
+		summary.summary_error = write_summary(options.output_dir, summary);
+	}
+	auto end_time = std::chrono::high_resolution_clock::now();
+	summary.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+	return summary;
+}
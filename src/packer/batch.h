@@ -0,0 +1,78 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Solves many instance files in
+ *                one parse/solve/write pipeline
+ *=============================================**/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <functional>
+
+#include "../types.h"
+
+/**============================================
+ *                BatchEntry
+ * One instance's outcome. The result keeps its
+ * heights and times but not its rectangles, which
+ * are dropped once written.
+ *=============================================**/
+struct BatchEntry
+{
+	std::string path{};
+	uint32_t W = 0;
+	uint32_t N = 0;
+	uint32_t known_h = 0; // Optimal height the instance gives, 0 if unknown
+	Result result{};
+	std::string error{}; // Why reading or solving failed, empty on success
+};
+
+/**============================================
+ *               BatchOptions
+ *=============================================**/
+struct BatchOptions
+{
+	uint32_t W = 0; // Width of instances that don't give theirs, 0 = such files fail
+	bool rotations = false;
+	Heuristic strategy = Heuristic::DescendingHeight;
+	bool all_heuristics = false; // Best of every heuristic instead of strategy
+	size_t parsers = 2;			 // Threads reading files
+	size_t solvers = 0;			 // Threads solving, 0 = one per hardware thread
+	std::string output_dir{};	 // Gets <dirs>/<name>[_<problem>]_result.csv per instance and summary.csv, empty = no files
+
+	// Called from the writer thread, one call at a time, in the order instances finish
+	std::function<void(const BatchEntry &entry)> on_result{};
+};
+
+struct BatchSummary
+{
+	std::vector<BatchEntry> entries{}; // In input order
+	size_t failed = 0;
+	uint64_t elapsed_ms = 0;
+	std::string summary_error{}; // Why summary.csv couldn't be written, empty on success
+};
+
+// Instance files (.txt, .lst, .bin) under a directory, recursively and sorted, or the paths listed one per line
+// in a file. A file of several problems (OR-Lib) is listed as <file>:<problem> for each
+std::vector<std::string> list_instances(const std::string &source);
+
+/**============================================
+ *                solve_batch
+ * Parser threads read the files into a bounded
+ * queue, solver threads (one Solver each) take
+ * instances from it and pass results through a
+ * second bounded queue to a single writer thread.
+ * At most a few instances per thread are held in
+ * memory at once, whatever the number of files.
+ * A file that fails to read or solve is recorded
+ * with its error and the batch goes on.
+ * Result files mirror the directories of the
+ * instances under the deepest one holding them
+ * all. An instance whose result file is an
+ * earlier instance's (same name, another
+ * extension) fails without being solved.
+ *=============================================**/
+BatchSummary solve_batch(const std::vector<std::string> &files, const BatchOptions &options);
+
+#endif
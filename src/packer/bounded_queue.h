@@ -0,0 +1,71 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Fixed capacity queue between
+ *                pipeline stages
+ *=============================================**/
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <condition_variable>
+
+/**============================================
+ *               BoundedQueue
+ * push() blocks while the queue is full, so a
+ * fast stage can't run ahead of a slow one by
+ * more than capacity items. pop() blocks until
+ * an item comes, and returns nothing once the
+ * queue is closed and empty.
+ *=============================================**/
+template <typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {}
+	BoundedQueue(const BoundedQueue &) = delete;
+	BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+	void push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_full_.wait(lock, [this]()
+					   { return items_.size() < capacity_; });
+		items_.push_back(std::move(item));
+		not_empty_.notify_one();
+	}
+
+	std::optional<T> pop()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_empty_.wait(lock, [this]()
+						{ return !items_.empty() || closed_; });
+		if (items_.empty())
+			return std::nullopt;
+		T item = std::move(items_.front());
+		items_.pop_front();
+		not_full_.notify_one();
+		return item;
+	}
+
+	// No more pushes: pop() drains what is left, then returns nothing
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		closed_ = true;
+		not_empty_.notify_all();
+	}
+
+private:
+	size_t capacity_;
+	std::deque<T> items_{};
+	std::mutex mutex_{};
+	std::condition_variable not_full_{};
+	std::condition_variable not_empty_{};
+	bool closed_ = false;
+};
+
+#endif
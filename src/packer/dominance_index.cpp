@@ -0,0 +1,165 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Containment queries over holes
+ *                as 4D dominance queries
+ *=============================================**/
+
+#include <algorithm>
+
+#include "dominance_index.h"
+
+void DominanceIndex::clear()
+{
+	for (Level &level : levels_)
+	{
+		level.tree.clear();
+		level.dead.clear();
+	}
+	pending_.clear();
+	slot_.clear();
+	level_.clear();
+	live_ = 0;
+	dead_count_ = 0;
+}
+
+void DominanceIndex::insert(uint32_t id, const Rect &hole)
+{
+	if (id >= slot_.size())
+	{
+		slot_.resize(id + 1, NONE);
+		level_.resize(id + 1, PENDING);
+	}
+	slot_[id] = static_cast<uint32_t>(pending_.size());
+	level_[id] = PENDING;
+	pending_.push_back(to_key(hole, id));
+	live_++;
+
+	// Pending keys are scanned on every query
+	if (pending_.size() > MAX_PENDING)
+	{
+		merge(false);
+	}
+}
+
+void DominanceIndex::remove(uint32_t id)
+{
+	if (id >= slot_.size() || slot_[id] == NONE)
+		return;
+
+	uint32_t slot = slot_[id];
+	if (level_[id] != PENDING)
+	{
+		levels_[level_[id]].dead[slot] = 1;
+		dead_count_++;
+	}
+	else
+	{
+		pending_[slot] = pending_.back();
+		slot_[pending_[slot].id] = slot;
+		pending_.pop_back();
+	}
+	slot_[id] = NONE;
+	live_--;
+
+	if (dead_count_ > live_)
+	{
+		merge(true);
+	}
+}
+
+// Moves the pending keys, and the levels up to the first free one, into that free one.
+// Level i holds at most MAX_PENDING << i keys, and the keys merged always fit in the first
+// free level. With all, every level is merged into the smallest one holding them all
+void DominanceIndex::merge(bool all)
+{
+	merged_.assign(pending_.begin(), pending_.end());
+	pending_.clear();
+
+	size_t target = 0;
+	while (target < levels_.size() && (all || !levels_[target].tree.empty()))
+	{
+		take_live(levels_[target]);
+		target++;
+	}
+	if (all)
+	{
+		target = 0;
+		while ((size_t(MAX_PENDING) << target) < merged_.size())
+			target++;
+	}
+	if (target >= levels_.size())
+		levels_.resize(target + 1);
+
+	levels_[target].tree.assign(merged_.begin(), merged_.end());
+	build(target);
+}
+
+// Appends the live keys of level to merged_ and empties it
+void DominanceIndex::take_live(Level &level)
+{
+	for (size_t i = 0; i < level.tree.size(); ++i)
+	{
+		if (level.dead[i])
+			dead_count_--;
+		else
+			merged_.push_back(level.tree[i]);
+	}
+	level.tree.clear();
+	level.dead.clear();
+}
+
+// Balances the keys of level into a k-d tree and points their slots at it
+void DominanceIndex::build(uint32_t level_index)
+{
+	Level &level = levels_[level_index];
+	level.dead.assign(level.tree.size(), 0);
+	if (!level.tree.empty())
+		build_node(level, 1, 0, level.tree.size(), 0);
+
+	for (size_t i = 0; i < level.tree.size(); ++i)
+	{
+		slot_[level.tree[i].id] = static_cast<uint32_t>(i);
+		level_[level.tree[i].id] = static_cast<uint8_t>(level_index);
+	}
+}
+
+// Splits [lo, hi) at its middle on coordinate depth % 4 and records its bounds
+void DominanceIndex::build_node(Level &level, uint32_t node, size_t lo, size_t hi, uint32_t depth)
+{
+	std::vector<Key> &tree = level.tree;
+	std::vector<Bounds> &bounds = level.bounds;
+	if (node >= bounds.size())
+		bounds.resize(node + 1);
+
+	if (hi - lo <= LEAF_SIZE)
+	{
+		Bounds b{tree[lo], tree[lo]};
+		for (size_t i = lo + 1; i < hi; ++i)
+		{
+			for (uint32_t k = 0; k < 4; ++k)
+			{
+				b.min.k[k] = std::min(b.min.k[k], tree[i].k[k]);
+				b.max.k[k] = std::max(b.max.k[k], tree[i].k[k]);
+			}
+		}
+		bounds[node] = b;
+		return;
+	}
+
+	size_t mid = lo + (hi - lo) / 2;
+	uint32_t axis = depth % 4;
+	std::nth_element(tree.begin() + lo, tree.begin() + mid, tree.begin() + hi, [axis](const Key &a, const Key &b)
+					 { return a.k[axis] < b.k[axis]; });
+	build_node(level, 2 * node, lo, mid, depth + 1);
+	build_node(level, 2 * node + 1, mid, hi, depth + 1);
+
+	Bounds b = bounds[2 * node];
+	const Bounds &right = bounds[2 * node + 1];
+	for (uint32_t k = 0; k < 4; ++k)
+	{
+		b.min.k[k] = std::min(b.min.k[k], right.min.k[k]);
+		b.max.k[k] = std::max(b.max.k[k], right.max.k[k]);
+	}
+	bounds[node] = b;
+}
@@ -0,0 +1,153 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Containment queries over holes
+ *                as 4D dominance queries
+ *=============================================**/
+
+#ifndef DOMINANCE_INDEX_H
+#define DOMINANCE_INDEX_H
+
+#include "../types.h"
+
+/**============================================
+ *              DominanceIndex
+ * A hole H contains a rect S iff the key
+ * (x, y, -x2, -y2) of H is <= the key of S in
+ * every coordinate, so "is S inside a hole" is a
+ * dominance query. Keys live in k-d trees with
+ * per-node coordinate bounds, of doubling sizes
+ * (the logarithmic method): inserts go to a short
+ * pending list scanned linearly, and a full list
+ * is merged with the smaller trees into the next
+ * free one, so a key is rebuilt O(log(M)) times.
+ * Removed keys are marked dead, and all the trees
+ * are merged into one once most keys are dead.
+ * Hole ids must be unique while indexed.
+ *=============================================**/
+class DominanceIndex
+{
+public:
+	void clear();
+	void insert(uint32_t id, const Rect &hole);
+	void remove(uint32_t id);
+	size_t size() const { return live_; }
+
+	// Visitors call f(id, hole) for each matching hole, f returns true to stop early.
+	// They return true if the visit was stopped.
+
+	// Holes that contain (or are equal to) rect
+	template <typename F>
+	bool for_each_containing(const Rect &rect, F &&f) const
+	{
+		Key q = to_key(rect, 0);
+		auto prune = [&q](const Key &min, const Key &)
+		{ return min.k[0] > q.k[0] || min.k[1] > q.k[1] || min.k[2] > q.k[2] || min.k[3] > q.k[3]; };
+		auto match = [&q](const Key &p)
+		{ return p.k[0] <= q.k[0] && p.k[1] <= q.k[1] && p.k[2] <= q.k[2] && p.k[3] <= q.k[3]; };
+		return visit(prune, match, f);
+	}
+
+	// Holes inside (or equal to) area
+	template <typename F>
+	bool for_each_inside(const Rect &area, F &&f) const
+	{
+		Key q = to_key(area, 0);
+		auto prune = [&q](const Key &, const Key &max)
+		{ return max.k[0] < q.k[0] || max.k[1] < q.k[1] || max.k[2] < q.k[2] || max.k[3] < q.k[3]; };
+		auto match = [&q](const Key &p)
+		{ return p.k[0] >= q.k[0] && p.k[1] >= q.k[1] && p.k[2] >= q.k[2] && p.k[3] >= q.k[3]; };
+		return visit(prune, match, f);
+	}
+
+	// True if rect is inside (or equal to) any indexed hole
+	bool any_containing(const Rect &rect) const
+	{
+		return for_each_containing(rect, [](uint32_t, const Rect &)
+								   { return true; });
+	}
+
+private:
+	static constexpr uint32_t LEAF_SIZE = 8;
+	static constexpr uint32_t MAX_PENDING = 32; // Level i holds at most MAX_PENDING << i keys
+	static constexpr uint32_t NONE = UINT32_MAX;
+	static constexpr uint8_t PENDING = UINT8_MAX;
+
+	struct Key
+	{
+		uint32_t k[4]; // x, y, -x2, -y2 (as UINT32_MAX - x2 and UINT32_MAX - y2)
+		uint32_t id;
+	};
+
+	struct Bounds
+	{
+		Key min, max;
+	};
+
+	struct Level
+	{
+		std::vector<Key> tree{};	 // Implicit k-d tree: node [lo, hi) splits at its middle
+		std::vector<Bounds> bounds{}; // Bounds of node [lo, hi), indexed like a heap
+		std::vector<uint8_t> dead{};	 // Removed keys still in tree
+	};
+
+	std::vector<Level> levels_{};
+	std::vector<Key> pending_{};	// Inserted since the last merge, scanned linearly
+	std::vector<uint32_t> slot_{};	// Index in its level's tree or in pending_, by hole id
+	std::vector<uint8_t> level_{};	// Level slot_ points into, PENDING for pending_, by hole id
+	std::vector<Key> merged_{};		// Scratch for merges
+	size_t live_ = 0;
+	size_t dead_count_ = 0;
+
+	static Key to_key(const Rect &rect, uint32_t id)
+	{
+		return Key{{rect.x(), rect.y(), UINT32_MAX - rect.x2(), UINT32_MAX - rect.y2()}, id};
+	}
+
+	static Rect to_rect(const Key &key)
+	{
+		return Rect(key.k[0], key.k[1], UINT32_MAX - key.k[2] - key.k[0], UINT32_MAX - key.k[3] - key.k[1]);
+	}
+
+	void merge(bool all);
+	void take_live(Level &level);
+	void build(uint32_t level);
+	static void build_node(Level &level, uint32_t node, size_t lo, size_t hi, uint32_t depth);
+
+	template <typename Prune, typename Match, typename F>
+	bool visit(Prune &prune, Match &match, F &f) const
+	{
+		for (const Key &p : pending_)
+		{
+			if (match(p) && f(p.id, to_rect(p)))
+				return true;
+		}
+		for (const Level &level : levels_)
+		{
+			if (!level.tree.empty() && visit_node(level, 1, 0, level.tree.size(), prune, match, f))
+				return true;
+		}
+		return false;
+	}
+
+	template <typename Prune, typename Match, typename F>
+	static bool visit_node(const Level &level, size_t node, size_t lo, size_t hi, Prune &prune, Match &match, F &f)
+	{
+		if (prune(level.bounds[node].min, level.bounds[node].max))
+			return false;
+		if (hi - lo <= LEAF_SIZE)
+		{
+			for (size_t i = lo; i < hi; ++i)
+			{
+				if (!level.dead[i] && match(level.tree[i]) && f(level.tree[i].id, to_rect(level.tree[i])))
+					return true;
+			}
+			return false;
+		}
+		size_t mid = lo + (hi - lo) / 2;
+		return visit_node(level, 2 * node, lo, mid, prune, match, f) ||
+			   visit_node(level, 2 * node + 1, mid, hi, prune, match, f);
+	}
+};
+
+#endif
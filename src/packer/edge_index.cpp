@@ -0,0 +1,64 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Hash maps of holes by their
+ *                edges, to find merge partners
+ *=============================================**/
+
+#include "edge_index.h"
+
+EdgeIndex::EdgeIndex(Arena &arena)
+	: left_(0, EdgeHash{}, std::equal_to<Edge>{}, ArenaAllocator<std::pair<const Edge, Entry>>(arena)),
+	  right_(0, EdgeHash{}, std::equal_to<Edge>{}, ArenaAllocator<std::pair<const Edge, Entry>>(arena)),
+	  top_(0, EdgeHash{}, std::equal_to<Edge>{}, ArenaAllocator<std::pair<const Edge, Entry>>(arena)),
+	  bottom_(0, EdgeHash{}, std::equal_to<Edge>{}, ArenaAllocator<std::pair<const Edge, Entry>>(arena))
+{
+}
+
+void EdgeIndex::clear()
+{
+	left_.clear();
+	right_.clear();
+	top_.clear();
+	bottom_.clear();
+}
+
+void EdgeIndex::insert(uint32_t id, const Rect &hole)
+{
+	left_.emplace(Edge{hole.x(), hole.y(), hole.h()}, Entry{hole, id});
+	right_.emplace(Edge{hole.x2(), hole.y(), hole.h()}, Entry{hole, id});
+	top_.emplace(Edge{hole.y(), hole.x(), hole.w()}, Entry{hole, id});
+	bottom_.emplace(Edge{hole.y2(), hole.x(), hole.w()}, Entry{hole, id});
+}
+
+void EdgeIndex::remove(uint32_t id, const Rect &hole)
+{
+	erase(left_, Edge{hole.x(), hole.y(), hole.h()}, id);
+	erase(right_, Edge{hole.x2(), hole.y(), hole.h()}, id);
+	erase(top_, Edge{hole.y(), hole.x(), hole.w()}, id);
+	erase(bottom_, Edge{hole.y2(), hole.x(), hole.w()}, id);
+}
+
+bool EdgeIndex::contains(uint32_t id, const Rect &hole) const
+{
+	auto range = left_.equal_range(Edge{hole.x(), hole.y(), hole.h()});
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.id == id)
+			return it->second.hole == hole;
+	}
+	return false;
+}
+
+void EdgeIndex::erase(EdgeMap &map, const Edge &edge, uint32_t id)
+{
+	auto range = map.equal_range(edge);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.id == id)
+		{
+			map.erase(it);
+			return;
+		}
+	}
+}
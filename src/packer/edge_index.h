@@ -0,0 +1,122 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Hash maps of holes by their
+ *                edges, to find merge partners
+ *=============================================**/
+
+#ifndef EDGE_INDEX_H
+#define EDGE_INDEX_H
+
+#include <unordered_map>
+
+#include "../types.h"
+#include "arena.h"
+
+/**============================================
+ *                 EdgeIndex
+ * Two holes merge when one's right (or bottom)
+ * edge is exactly the other's left (or top) edge.
+ * Each hole is stored under its four edges, so the
+ * holes sharing a whole edge with a hole are found
+ * in O(1) expected time. Map nodes come from
+ * the solver's arena.
+ * Hole ids must be unique while indexed.
+ *=============================================**/
+class EdgeIndex
+{
+public:
+	explicit EdgeIndex(Arena &arena);
+
+	void clear();
+	void insert(uint32_t id, const Rect &hole);
+	void remove(uint32_t id, const Rect &hole);
+
+	// True if hole is indexed with this id and these extents
+	bool contains(uint32_t id, const Rect &hole) const;
+
+	// Visitors call f(id, other) for each matching hole, f returns true to stop early.
+	// They return true if the visit was stopped.
+
+	// Holes whose left edge is the right edge of hole
+	template <typename F>
+	bool for_each_right_of(const Rect &hole, F &&f) const
+	{
+		return visit(left_, Edge{hole.x2(), hole.y(), hole.h()}, f);
+	}
+
+	// Holes whose right edge is the left edge of hole
+	template <typename F>
+	bool for_each_left_of(const Rect &hole, F &&f) const
+	{
+		return visit(right_, Edge{hole.x(), hole.y(), hole.h()}, f);
+	}
+
+	// Holes whose top edge is the bottom edge of hole
+	template <typename F>
+	bool for_each_below(const Rect &hole, F &&f) const
+	{
+		return visit(top_, Edge{hole.y2(), hole.x(), hole.w()}, f);
+	}
+
+	// Holes whose bottom edge is the top edge of hole
+	template <typename F>
+	bool for_each_above(const Rect &hole, F &&f) const
+	{
+		return visit(bottom_, Edge{hole.y(), hole.x(), hole.w()}, f);
+	}
+
+private:
+	struct Edge
+	{
+		uint32_t at;	 // x of a vertical edge, y of a horizontal one
+		uint32_t from;	 // Where the edge starts along it
+		uint32_t length; // h of a vertical edge, w of a horizontal one
+
+		bool operator==(const Edge &other) const
+		{
+			return at == other.at && from == other.from && length == other.length;
+		}
+	};
+
+	// An indexed hole
+	struct Entry
+	{
+		Rect hole;
+		uint32_t id;
+	};
+
+	struct EdgeHash
+	{
+		size_t operator()(const Edge &edge) const
+		{
+			uint64_t h = edge.at;
+			h = h * 0x9E3779B97F4A7C15ULL ^ edge.from;
+			h = h * 0x9E3779B97F4A7C15ULL ^ edge.length;
+			return std::hash<uint64_t>{}(h);
+		}
+	};
+
+	using EdgeMap = std::unordered_multimap<Edge, Entry, EdgeHash, std::equal_to<Edge>, ArenaAllocator<std::pair<const Edge, Entry>>>;
+
+	EdgeMap left_;
+	EdgeMap right_;
+	EdgeMap top_;
+	EdgeMap bottom_;
+
+	static void erase(EdgeMap &map, const Edge &edge, uint32_t id);
+
+	template <typename F>
+	static bool visit(const EdgeMap &map, const Edge &edge, F &f)
+	{
+		auto range = map.equal_range(edge);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (f(it->second.id, it->second.hole))
+				return true;
+		}
+		return false;
+	}
+};
+
+#endif
@@ -0,0 +1,459 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Exact branch-and-bound solver
+ *                for small instances
+ *=============================================**/
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#include "exact.h"
+#include "packer.h"
+#include "lower_bound.h"
+#include "thread_pool.h"
+
+constexpr uint64_t NODE_BATCH = 256; // Nodes a worker counts before adding them up and checking the limits
+
+// Rectangles of one size, with rotations the short side is w
+struct SizeType
+{
+	uint32_t w, h;
+	uint32_t count;
+};
+
+// A subtree waiting in a deque
+struct Node
+{
+	PackerCheckpoint state{};
+	std::vector<uint32_t> left{}; // Rectangles left to place, by type
+	uint64_t waste = 0;			  // Area marked as waste
+};
+
+struct WorkerQueue
+{
+	std::mutex mutex{};
+	std::deque<Node> nodes{}; // The owner takes from the back, thieves from the front
+};
+
+/**============================================
+ *                ExactSearch
+ * One decision search: is there a packing no
+ * higher than target? Holds what the workers
+ * share: the deques, the packing found and the
+ * limits.
+ *=============================================**/
+class ExactSearch
+{
+public:
+	ExactSearch(uint32_t W, bool rotations, const std::vector<SizeType> &types, uint64_t total_area, uint32_t target,
+				std::chrono::high_resolution_clock::time_point deadline, uint64_t max_nodes, size_t workers)
+		: W_(W), rotations_(rotations), types_(types), total_area_(total_area), target_(target), deadline_(deadline),
+		  max_nodes_(max_nodes), queues_(workers)
+	{
+	}
+
+	// False if it stopped at a limit before finding a packing or ruling them all out
+	bool run(ThreadPool &pool)
+	{
+		Node root{};
+		Packer packer(W_);
+		root.state = packer.checkpoint();
+		for (const SizeType &type : types_)
+		{
+			root.left.push_back(type.count);
+		}
+		pending_ = 1;
+		queues_[0].nodes.push_back(std::move(root));
+
+		for (size_t t = 0; t < queues_.size(); ++t)
+		{
+			pool.submit([this, t]()
+						{ work(t); });
+		}
+		pool.wait();
+		return !stopped_;
+	}
+
+	bool found() const { return found_; }
+	const std::vector<Shape> &packing() const { return packing_; } // Placed rectangles, ids count placements
+	uint64_t nodes() const { return nodes_.load(); }
+	uint64_t steals() const { return steals_.load(); }
+
+private:
+	uint32_t W_;
+	bool rotations_;
+	const std::vector<SizeType> &types_;
+	uint64_t total_area_;
+	uint32_t target_;
+	std::chrono::high_resolution_clock::time_point deadline_;
+	uint64_t max_nodes_;
+
+	std::vector<WorkerQueue> queues_;
+	std::atomic<uint64_t> pending_{0}; // Nodes queued or being searched
+	std::atomic<uint32_t> idle_{0};	   // Workers looking for a node
+	std::atomic<uint64_t> nodes_{0};
+	std::atomic<uint64_t> steals_{0};
+
+	std::mutex done_mutex_{};
+	std::atomic<bool> done_{false}; // Found a packing or stopped at a limit, set under done_mutex_
+	bool stopped_ = false;
+	bool found_ = false;
+	std::vector<Shape> packing_{};
+
+	// A place and orientation to branch on
+	struct Child
+	{
+		uint32_t type;
+		uint32_t w, h;
+	};
+
+	// What a worker is searching
+	struct Worker
+	{
+		size_t index;
+		Packer packer;
+		std::vector<uint32_t> left{};
+		uint64_t waste = 0;
+		uint64_t nodes = 0; // Not yet added to nodes_
+		bool idle = false;	// Counted in idle_
+		std::vector<uint8_t> reachable{}; // Scratch buffer of widest_fill
+		std::deque<std::vector<Child>> children{}; // Scratch buffers of search, one per depth
+	};
+
+	void work(size_t t)
+	{
+		Worker worker{t, Packer(W_)};
+		worker.packer.keep_undo(true);
+		Node node{};
+		while (!done_.load(std::memory_order_relaxed))
+		{
+			bool taken = take(t, node);
+			if (taken == worker.idle)
+			{
+				worker.idle = !taken;
+				if (worker.idle)
+					idle_++;
+				else
+					idle_--;
+			}
+			if (!taken)
+			{
+				if (pending_.load() == 0)
+					break;
+				std::this_thread::yield();
+				continue;
+			}
+
+			worker.packer.restore(node.state);
+			worker.left = std::move(node.left);
+			worker.waste = node.waste;
+			search(worker, 0);
+			pending_--;
+		}
+		if (worker.idle)
+			idle_--;
+		nodes_ += worker.nodes;
+	}
+
+	// Own deque's newest node, else another deque's oldest one
+	bool take(size_t t, Node &node)
+	{
+		for (size_t i = 0; i < queues_.size(); ++i)
+		{
+			WorkerQueue &queue = queues_[(t + i) % queues_.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.nodes.empty())
+				continue;
+			if (i == 0)
+			{
+				node = std::move(queue.nodes.back());
+				queue.nodes.pop_back();
+			}
+			else
+			{
+				node = std::move(queue.nodes.front());
+				queue.nodes.pop_front();
+				steals_++;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void count_node(Worker &worker)
+	{
+		if (++worker.nodes < NODE_BATCH)
+			return;
+		uint64_t nodes = nodes_ += worker.nodes;
+		worker.nodes = 0;
+		if ((max_nodes_ != 0 && nodes >= max_nodes_) || std::chrono::high_resolution_clock::now() >= deadline_)
+		{
+			std::lock_guard<std::mutex> lock(done_mutex_);
+			if (!done_)
+				stopped_ = true;
+			done_ = true;
+		}
+	}
+
+	void record(const Worker &worker)
+	{
+		std::lock_guard<std::mutex> lock(done_mutex_);
+		if (done_)
+			return;
+		packing_.assign(worker.packer.rectangles().begin(), worker.packer.rectangles().end());
+		found_ = true;
+		done_ = true;
+	}
+
+	// Rectangle fits with its corner at the first hole's corner
+	static bool fits_at_corner(const std::vector<Rect> &holes, uint32_t w, uint32_t h)
+	{
+		Rect corner = holes.front();
+		for (const Rect &hole : holes)
+		{
+			if (hole.x() != corner.x() || hole.y() != corner.y())
+				break;
+			if (w <= hole.w() && h <= hole.h())
+				return true;
+		}
+		return false;
+	}
+
+	// Widest total width, up to run, of rectangles left that could start side by side on row y
+	uint32_t widest_fill(Worker &worker, uint32_t y, uint32_t run) const
+	{
+		std::vector<uint8_t> &reachable = worker.reachable;
+		reachable.assign(run + 1, 0);
+		reachable[0] = 1;
+		for (uint32_t i = 0; i < types_.size(); ++i)
+		{
+			const SizeType &type = types_[i];
+			uint32_t upright = type.w <= run && y + type.h <= target_ ? type.w : 0;
+			uint32_t lying = rotations_ && type.h <= run && y + type.w <= target_ ? type.h : 0;
+			if (upright == 0 && lying == 0)
+				continue;
+			for (uint32_t k = 0; k < worker.left[i]; ++k)
+			{
+				for (uint32_t width = run; width-- > 0;)
+				{
+					if (!reachable[width])
+						continue;
+					if (upright != 0 && width + upright <= run)
+						reachable[width + upright] = 1;
+					if (lying != 0 && width + lying <= run)
+						reachable[width + lying] = 1;
+				}
+				if (reachable[run])
+					return run;
+			}
+		}
+		uint32_t widest = run;
+		while (!reachable[widest])
+			widest--;
+		return widest;
+	}
+
+	// Depth first search from the worker's state, depth nodes below the node taken. Undoes its
+	// placements on the way back, so it leaves the state as it found it unless the search is done
+	void search(Worker &worker, size_t depth)
+	{
+		count_node(worker);
+		if (done_.load(std::memory_order_relaxed))
+			return;
+
+		Packer &packer = worker.packer;
+		std::vector<uint32_t> &left = worker.left;
+		if (std::all_of(left.begin(), left.end(), [](uint32_t count)
+						{ return count == 0; }))
+		{
+			record(worker);
+			return;
+		}
+
+		// Everything before the corner is placed or waste, the rest goes at or above it
+		const std::vector<Rect> &holes = packer.holes();
+		uint32_t x = holes.front().x(), y = holes.front().y();
+		uint64_t room = uint64_t(W_) * target_;
+		if (y >= target_ || total_area_ + worker.waste > room)
+			return;
+
+		// Children: each size and orientation fitting at the corner, then waste.
+		// narrowest is the narrowest rectangle left that could start on this row
+		if (depth == worker.children.size())
+			worker.children.emplace_back();
+		std::vector<Child> &children = worker.children[depth];
+		children.clear();
+		uint32_t narrowest = UINT32_MAX;
+		for (uint32_t i = 0; i < types_.size(); ++i)
+		{
+			if (left[i] == 0)
+				continue;
+			const SizeType &type = types_[i];
+			bool upright = type.w <= W_ && y + type.h <= target_;
+			bool lying = rotations_ && type.w != type.h && type.h <= W_ && y + type.w <= target_;
+			if (!upright && !lying)
+				return;
+			if (upright)
+			{
+				narrowest = std::min(narrowest, type.w);
+				if (fits_at_corner(holes, type.w, type.h))
+					children.push_back(Child{i, type.w, type.h});
+			}
+			if (lying)
+			{
+				narrowest = std::min(narrowest, type.h);
+				if (fits_at_corner(holes, type.h, type.w))
+					children.push_back(Child{i, type.h, type.w});
+			}
+		}
+
+		// Waste one cell, or the free run at the corner if nothing left is narrow enough for the rest of it
+		uint32_t run = 0;
+		for (const Rect &hole : holes)
+		{
+			if (hole.x() != x || hole.y() != y)
+				break;
+			run = std::max(run, hole.w());
+		}
+
+		// The cells of the run are covered by rectangles starting on this row, or waste
+		if (total_area_ + worker.waste + (run - widest_fill(worker, y, run)) > room)
+			return;
+
+		uint32_t waste_w = run - 1 >= narrowest ? 1 : run;
+		bool may_waste = total_area_ + worker.waste + waste_w <= room;
+
+		// Rectangles filling the run first, they leave no gap
+		std::stable_partition(children.begin(), children.end(), [run](const Child &child)
+							  { return child.w == run; });
+
+		size_t count = children.size() + (may_waste ? 1 : 0);
+		for (size_t c = 0; c < count; ++c)
+		{
+			bool is_waste = c == children.size();
+			if (is_waste)
+			{
+				packer.fill(Rect(x, y, waste_w, 1));
+				worker.waste += waste_w;
+			}
+			else
+			{
+				packer.place_at(x, y, children[c].w, children[c].h, children[c].w != types_[children[c].type].w);
+				left[children[c].type]--;
+			}
+
+			// Hand the child to an idle worker, unless it is the last one
+			if (c + 1 < count && idle_.load(std::memory_order_relaxed) > 0)
+			{
+				Node node{packer.checkpoint(), left, worker.waste};
+				pending_++;
+				std::lock_guard<std::mutex> lock(queues_[worker.index].mutex);
+				queues_[worker.index].nodes.push_back(std::move(node));
+			}
+			else
+			{
+				search(worker, depth + 1);
+				if (done_.load(std::memory_order_relaxed))
+					return;
+			}
+
+			packer.undo();
+			if (is_waste)
+				worker.waste -= waste_w;
+			else
+				left[children[c].type]++;
+		}
+	}
+};
+
+ExactResult solve_exact(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, const ExactOptions &options)
+{
+	auto start_time = std::chrono::high_resolution_clock::now();
+	auto deadline = start_time + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(options.time_limit));
+	ThreadPool pool(options.threads);
+
+	ExactResult exact{};
+	exact.lower_bound = height_lower_bound(W, rectangles, rotations, &pool).value;
+	exact.result = best_result(solve_portfolio(W, rectangles, rotations, pool));
+	if (options.on_improvement)
+		options.on_improvement(exact.result.h);
+
+	// Rectangles of a size are interchangeable, they are branched on once
+	std::map<std::pair<uint32_t, uint32_t>, std::vector<const Shape *>> by_size;
+	uint64_t total_area = 0;
+	for (const Shape &rectangle : rectangles)
+	{
+		uint32_t w = rectangle.w(), h = rectangle.h();
+		if (rotations && w > h)
+			std::swap(w, h);
+		by_size[{w, h}].push_back(&rectangle);
+		total_area += rectangle.area();
+	}
+	std::vector<SizeType> types;
+	for (const auto &size : by_size)
+	{
+		types.push_back(SizeType{size.first.first, size.first.second, static_cast<uint32_t>(size.second.size())});
+	}
+
+	// Large rectangles first, they have the fewest places to go
+	std::sort(types.begin(), types.end(), [](const SizeType &a, const SizeType &b)
+			  {
+		if (uint64_t(a.w) * a.h != uint64_t(b.w) * b.h)
+			return uint64_t(a.w) * a.h > uint64_t(b.w) * b.h;
+		return a.h > b.h; });
+
+	// Heights from the lower bound up: each one ruled out raises the bound, the first one
+	// packed is optimal. Low heights leave little room for waste and are quick to rule out
+	bool stopped = !exact.result.complete;
+	while (!stopped && exact.lower_bound < exact.result.h)
+	{
+		uint64_t max_nodes = options.max_nodes == 0 ? 0 : options.max_nodes - std::min(options.max_nodes, exact.nodes);
+		ExactSearch search(W, rotations, types, total_area, exact.lower_bound, deadline, max_nodes, pool.size());
+		stopped = (options.max_nodes != 0 && max_nodes == 0) || !search.run(pool);
+		exact.nodes += search.nodes();
+		exact.steals += search.steals();
+		if (stopped)
+			break;
+		if (!search.found())
+		{
+			exact.lower_bound++;
+			if (options.on_bound)
+				options.on_bound(exact.lower_bound);
+			continue;
+		}
+
+		// Give the placed rectangles the ids of inputs of their size
+		std::map<std::pair<uint32_t, uint32_t>, size_t> used;
+		Result &result = exact.result;
+		result.h = 0;
+		result.rectangles.clear();
+		for (const Shape &placed : search.packing())
+		{
+			std::pair<uint32_t, uint32_t> size{placed.w(), placed.h()};
+			if (rotations && size.first > size.second)
+				std::swap(size.first, size.second);
+			const Shape &input = *by_size[size][used[size]++];
+			result.rectangles.emplace_back(input.id(), placed.rect(), placed.w() != input.w());
+			result.h = std::max(result.h, placed.y2());
+		}
+		std::sort(result.rectangles.begin(), result.rectangles.end(), [](const Shape &a, const Shape &b)
+				  { return a.id() < b.id(); });
+		result.loss = (1.0 - double(total_area) / (uint64_t(result.w) * result.h)) * 100.0;
+		if (options.on_improvement)
+			options.on_improvement(result.h);
+	}
+
+	exact.optimal = !stopped;
+	if (exact.optimal)
+		exact.lower_bound = exact.result.h;
+	exact.result.opt_h = exact.lower_bound;
+
+	auto end_time = std::chrono::high_resolution_clock::now();
+	exact.result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+	return exact;
+}
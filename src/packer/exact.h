@@ -0,0 +1,71 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Exact branch-and-bound solver
+ *                for small instances
+ *=============================================**/
+
+#ifndef EXACT_H
+#define EXACT_H
+
+#include <functional>
+
+#include "../types.h"
+
+/**============================================
+ *                ExactOptions
+ *=============================================**/
+struct ExactOptions
+{
+	double time_limit = 10.0; // Seconds
+	uint64_t max_nodes = 0;	  // Stop after about this many nodes, 0 = only the time limit stops the search
+	size_t threads = 0;		  // 0 = one per hardware thread
+
+	// Called with each better height found, and with each height ruled out as the lower bound rises
+	std::function<void(uint32_t best_h)> on_improvement{};
+	std::function<void(uint32_t lower_bound)> on_bound{};
+};
+
+/**============================================
+ *                ExactResult
+ *=============================================**/
+struct ExactResult
+{
+	Result result{};		  // Best packing found, its opt_h is lower_bound
+	bool optimal = false;	  // result.h is proven optimal
+	uint32_t lower_bound = 0; // result.h if optimal, else the instance's lower bound
+	uint64_t nodes = 0;		  // Search nodes expanded
+	uint64_t steals = 0;	  // Nodes a worker took from another one
+};
+
+/**============================================
+ *                solve_exact
+ * Branch-and-bound over packings, for instances
+ * of up to a few dozen rectangles. Starts from
+ * the best heuristic packing and the lower
+ * bound, then tries to pack within each height
+ * from the bound up: a height ruled out raises
+ * the bound, the first one packed is optimal.
+ * Low heights leave little room for waste, so
+ * they are the quickest to rule out.
+ * A node branches at the lowest, then leftmost,
+ * free point, which is the corner of the first
+ * maximal hole: either a rectangle goes there,
+ * one per distinct size and orientation left,
+ * or the point is waste. Every packing can be
+ * built this way. Nodes are cut when the waste
+ * so far and the area left don't fit under the
+ * height, or a rectangle left doesn't fit above
+ * the point.
+ * Workers search depth first and share subtrees
+ * through work stealing: while a worker is idle,
+ * the others push their sibling nodes to their
+ * deques, which idle workers steal from.
+ * The optimal height doesn't depend on the
+ * thread count, the packing reaching it may.
+ * Stopped at a limit, the result is the best
+ * packing found and the gap to the bound.
+ *=============================================**/
+ExactResult solve_exact(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, const ExactOptions &options);
+
+#endif
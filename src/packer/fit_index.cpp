@@ -0,0 +1,38 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Perfect fit queries over holes
+ *=============================================**/
+
+#include "fit_index.h"
+
+/**============================================
+ *                 FitIndex
+ *=============================================**/
+FitIndex::FitIndex(Arena &arena)
+	: sizes_(0, std::hash<uint64_t>{}, std::equal_to<uint64_t>{}, ArenaAllocator<std::pair<const uint64_t, uint32_t>>(arena))
+{
+}
+
+void FitIndex::clear()
+{
+	sizes_.clear();
+}
+
+void FitIndex::insert(uint32_t id, const Rect &hole)
+{
+	sizes_.emplace(size_key(hole.w(), hole.h()), id);
+}
+
+void FitIndex::remove(uint32_t id, const Rect &hole)
+{
+	auto range = sizes_.equal_range(size_key(hole.w(), hole.h()));
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == id)
+		{
+			sizes_.erase(it);
+			return;
+		}
+	}
+}
@@ -0,0 +1,55 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Perfect fit queries over holes
+ *=============================================**/
+
+#ifndef FIT_INDEX_H
+#define FIT_INDEX_H
+
+#include <unordered_map>
+
+#include "../types.h"
+#include "arena.h"
+
+/**============================================
+ *                 FitIndex
+ * Answers "which holes have exactly this size"
+ * (the perfect fits) from a hash map kept up to
+ * date as holes are inserted and removed. Map
+ * nodes come from the solver's arena. The first
+ * hole of at least a size is HoleArrays' query.
+ * Hole ids must be unique while indexed.
+ *=============================================**/
+class FitIndex
+{
+public:
+	explicit FitIndex(Arena &arena);
+
+	void clear();
+	void insert(uint32_t id, const Rect &hole);
+	void remove(uint32_t id, const Rect &hole);
+
+	// Calls f(id) for each hole of exactly w by h
+	template <typename F>
+	void for_each_sized(uint32_t w, uint32_t h, F &&f) const
+	{
+		auto range = sizes_.equal_range(size_key(w, h));
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			f(it->second);
+		}
+	}
+
+private:
+	using SizeMap = std::unordered_multimap<uint64_t, uint32_t, std::hash<uint64_t>, std::equal_to<uint64_t>, ArenaAllocator<std::pair<const uint64_t, uint32_t>>>;
+
+	SizeMap sizes_; // Hole ids by size
+
+	static uint64_t size_key(uint32_t w, uint32_t h)
+	{
+		return (static_cast<uint64_t>(w) << 32) | h;
+	}
+};
+
+#endif
@@ -0,0 +1,258 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Hole list as separate x, y, w
+ *                and h arrays, for SIMD scans
+ *=============================================**/
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HOLE_ARRAYS_X86 1
+#else
+#define HOLE_ARRAYS_X86 0
+#endif
+
+#include "hole_arrays.h"
+
+/**============================================
+ *                 Fit kernels
+ * Bit i of the mask is set if hole i of the
+ * lanes is at least min_w by min_h. All kernels
+ * return the same mask.
+ *=============================================**/
+using FitMaskKernel = uint32_t (*)(const uint32_t *w, const uint32_t *h, uint32_t min_w, uint32_t min_h);
+
+static uint32_t fit_mask_scalar(const uint32_t *w, const uint32_t *h, uint32_t min_w, uint32_t min_h)
+{
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HoleArrays::LANES; ++i)
+	{
+		mask |= static_cast<uint32_t>(w[i] >= min_w && h[i] >= min_h) << i;
+	}
+	return mask;
+}
+
+#if HOLE_ARRAYS_X86
+// SSE2 only compares signed integers, flipping the sign bit keeps the unsigned order
+__attribute__((target("sse2"))) static uint32_t fit_mask_sse2(const uint32_t *w, const uint32_t *h, uint32_t min_w, uint32_t min_h)
+{
+	const __m128i flip = _mm_set1_epi32(INT32_MIN);
+	const __m128i too_narrow = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(min_w)), flip);
+	const __m128i too_short = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(min_h)), flip);
+
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HoleArrays::LANES; i += 4)
+	{
+		__m128i vw = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(w + i)), flip);
+		__m128i vh = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i)), flip);
+		__m128i misfit = _mm_or_si128(_mm_cmpgt_epi32(too_narrow, vw), _mm_cmpgt_epi32(too_short, vh));
+		mask |= static_cast<uint32_t>(~_mm_movemask_ps(_mm_castsi128_ps(misfit)) & 0xF) << i;
+	}
+	return mask;
+}
+
+__attribute__((target("avx2"))) static uint32_t fit_mask_avx2(const uint32_t *w, const uint32_t *h, uint32_t min_w, uint32_t min_h)
+{
+	const __m256i vmin_w = _mm256_set1_epi32(static_cast<int32_t>(min_w));
+	const __m256i vmin_h = _mm256_set1_epi32(static_cast<int32_t>(min_h));
+
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HoleArrays::LANES; i += 8)
+	{
+		__m256i vw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + i));
+		__m256i vh = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i));
+		__m256i fits_w = _mm256_cmpeq_epi32(_mm256_max_epu32(vw, vmin_w), vw);
+		__m256i fits_h = _mm256_cmpeq_epi32(_mm256_max_epu32(vh, vmin_h), vh);
+		mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(fits_w, fits_h)))) << i;
+	}
+	return mask;
+}
+#endif
+
+static FitMaskKernel pick_fit_mask()
+{
+#if HOLE_ARRAYS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return fit_mask_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return fit_mask_sse2;
+#endif
+	return fit_mask_scalar;
+}
+
+// Picked on first use, so no other static initializer can run before the pick
+static uint32_t fit_mask(const uint32_t *w, const uint32_t *h, uint32_t min_w, uint32_t min_h)
+{
+	static const FitMaskKernel kernel = pick_fit_mask();
+	return kernel(w, h, min_w, min_h);
+}
+
+/**============================================
+ *                Bounds kernels
+ * Bit i of the mask is set if hole i of the
+ * lanes has x < x_below, y < y_below,
+ * x + w > x2_above and y + h > y2_above. All
+ * kernels return the same mask.
+ *=============================================**/
+using BoundsMaskKernel = uint32_t (*)(const uint32_t *x, const uint32_t *y, const uint32_t *w, const uint32_t *h,
+									  uint32_t x_below, uint32_t y_below, uint32_t x2_above, uint32_t y2_above);
+
+static uint32_t bounds_mask_scalar(const uint32_t *x, const uint32_t *y, const uint32_t *w, const uint32_t *h,
+								   uint32_t x_below, uint32_t y_below, uint32_t x2_above, uint32_t y2_above)
+{
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HoleArrays::LANES; ++i)
+	{
+		mask |= static_cast<uint32_t>(x[i] < x_below && y[i] < y_below && x[i] + w[i] > x2_above && y[i] + h[i] > y2_above) << i;
+	}
+	return mask;
+}
+
+#if HOLE_ARRAYS_X86
+__attribute__((target("sse2"))) static uint32_t bounds_mask_sse2(const uint32_t *x, const uint32_t *y, const uint32_t *w, const uint32_t *h,
+																  uint32_t x_below, uint32_t y_below, uint32_t x2_above, uint32_t y2_above)
+{
+	const __m128i flip = _mm_set1_epi32(INT32_MIN);
+	const __m128i vx_below = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(x_below)), flip);
+	const __m128i vy_below = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(y_below)), flip);
+	const __m128i vx2_above = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(x2_above)), flip);
+	const __m128i vy2_above = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(y2_above)), flip);
+
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HoleArrays::LANES; i += 4)
+	{
+		__m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+		__m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+		__m128i vx2 = _mm_add_epi32(vx, _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + i)));
+		__m128i vy2 = _mm_add_epi32(vy, _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i)));
+		__m128i inside = _mm_and_si128(_mm_cmpgt_epi32(vx_below, _mm_xor_si128(vx, flip)), _mm_cmpgt_epi32(vy_below, _mm_xor_si128(vy, flip)));
+		inside = _mm_and_si128(inside, _mm_cmpgt_epi32(_mm_xor_si128(vx2, flip), vx2_above));
+		inside = _mm_and_si128(inside, _mm_cmpgt_epi32(_mm_xor_si128(vy2, flip), vy2_above));
+		mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(inside))) << i;
+	}
+	return mask;
+}
+
+__attribute__((target("avx2"))) static uint32_t bounds_mask_avx2(const uint32_t *x, const uint32_t *y, const uint32_t *w, const uint32_t *h,
+																  uint32_t x_below, uint32_t y_below, uint32_t x2_above, uint32_t y2_above)
+{
+	const __m256i flip = _mm256_set1_epi32(INT32_MIN);
+	const __m256i vx_below = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(x_below)), flip);
+	const __m256i vy_below = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(y_below)), flip);
+	const __m256i vx2_above = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(x2_above)), flip);
+	const __m256i vy2_above = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(y2_above)), flip);
+
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HoleArrays::LANES; i += 8)
+	{
+		__m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+		__m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+		__m256i vx2 = _mm256_add_epi32(vx, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + i)));
+		__m256i vy2 = _mm256_add_epi32(vy, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i)));
+		__m256i inside = _mm256_and_si256(_mm256_cmpgt_epi32(vx_below, _mm256_xor_si256(vx, flip)), _mm256_cmpgt_epi32(vy_below, _mm256_xor_si256(vy, flip)));
+		inside = _mm256_and_si256(inside, _mm256_cmpgt_epi32(_mm256_xor_si256(vx2, flip), vx2_above));
+		inside = _mm256_and_si256(inside, _mm256_cmpgt_epi32(_mm256_xor_si256(vy2, flip), vy2_above));
+		mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(inside))) << i;
+	}
+	return mask;
+}
+#endif
+
+static BoundsMaskKernel pick_bounds_mask()
+{
+#if HOLE_ARRAYS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return bounds_mask_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return bounds_mask_sse2;
+#endif
+	return bounds_mask_scalar;
+}
+
+/**============================================
+ *                 HoleArrays
+ *=============================================**/
+void HoleArrays::build(const std::vector<Rect> &holes)
+{
+	count_ = holes.size();
+	leaves_ = 1;
+	while (leaves_ * LANES < count_)
+		leaves_ *= 2;
+
+	x_.assign(leaves_ * LANES, UINT32_MAX);
+	y_.assign(leaves_ * LANES, UINT32_MAX);
+	w_.assign(leaves_ * LANES, 0);
+	h_.assign(leaves_ * LANES, 0);
+	for (size_t i = 0; i < count_; ++i)
+	{
+		x_[i] = holes[i].x();
+		y_[i] = holes[i].y();
+		w_[i] = holes[i].w();
+		h_[i] = holes[i].h();
+	}
+
+	max_w_.assign(2 * leaves_, 0);
+	max_h_.assign(2 * leaves_, 0);
+	for (size_t block = 0; block < leaves_; ++block)
+	{
+		size_t begin = block * LANES;
+		max_w_[leaves_ + block] = *std::max_element(w_.begin() + begin, w_.begin() + begin + LANES);
+		max_h_[leaves_ + block] = *std::max_element(h_.begin() + begin, h_.begin() + begin + LANES);
+	}
+	for (size_t node = leaves_ - 1; node >= 1; --node)
+	{
+		max_w_[node] = std::max(max_w_[2 * node], max_w_[2 * node + 1]);
+		max_h_[node] = std::max(max_h_[2 * node], max_h_[2 * node + 1]);
+	}
+}
+
+// The y stays, so lanes still start in y order. The tree keeps the old size as its max, which
+// only makes first_fitting check a block for nothing
+void HoleArrays::erase(size_t pos)
+{
+	x_[pos] = UINT32_MAX;
+	w_[pos] = 0;
+	h_[pos] = 0;
+}
+
+// Kernel picked on first use, like fit_mask's
+uint32_t HoleArrays::bounds_mask(size_t lane, const Bounds &bounds) const
+{
+	static const BoundsMaskKernel kernel = pick_bounds_mask();
+	return kernel(&x_[lane], &y_[lane], &w_[lane], &h_[lane], bounds.x_below, bounds.y_below, bounds.x2_above, bounds.y2_above);
+}
+
+size_t HoleArrays::first_fitting(size_t from, uint32_t w, uint32_t h) const
+{
+	if (from >= count_)
+		return NONE;
+
+	// Rest of the block holding from, then the next blocks whose max size fits
+	size_t block = from / LANES;
+	uint32_t mask = fit_mask(&w_[block * LANES], &h_[block * LANES], w, h) & (~0u << (from % LANES));
+	while (mask == 0)
+	{
+		block = find_block(1, 0, leaves_, block + 1, w, h);
+		if (block == NONE)
+			return NONE;
+		mask = fit_mask(&w_[block * LANES], &h_[block * LANES], w, h);
+	}
+	size_t found = block * LANES + __builtin_ctz(mask);
+	return found < count_ ? found : NONE;
+}
+
+// Leftmost block >= from in node [lo, hi) whose max width and height are at least w and h
+size_t HoleArrays::find_block(size_t node, size_t lo, size_t hi, size_t from, uint32_t w, uint32_t h) const
+{
+	if (hi <= from || max_w_[node] < w || max_h_[node] < h)
+		return NONE;
+	if (hi - lo == 1)
+		return lo;
+	size_t mid = lo + (hi - lo) / 2;
+	size_t found = find_block(2 * node, lo, mid, from, w, h);
+	return found != NONE ? found : find_block(2 * node + 1, mid, hi, from, w, h);
+}
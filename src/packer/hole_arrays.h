@@ -0,0 +1,96 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Hole list as separate x, y, w
+ *                and h arrays, for SIMD scans
+ *=============================================**/
+
+#ifndef HOLE_ARRAYS_H
+#define HOLE_ARRAYS_H
+
+#include <vector>
+
+#include "../types.h"
+
+/**============================================
+ *                 HoleArrays
+ * The hole list, sorted by (y, x), as separate
+ * x, y, w and h arrays by list position, rebuilt
+ * by build() after each update. Scans check
+ * LANES holes at a time with one SIMD kernel
+ * (AVX2 or SSE2, picked on its first query,
+ * scalar elsewhere) and stop at the first lane
+ * starting below the area, so short lists are
+ * scanned instead of indexed. "First hole from
+ * this position that is at least this size"
+ * goes down a tree of max widths/heights over
+ * blocks of LANES positions.
+ * erase() blanks a position until the next
+ * build: scans and fit queries skip it.
+ *=============================================**/
+class HoleArrays
+{
+public:
+	static constexpr size_t NONE = SIZE_MAX;
+	static constexpr uint32_t LANES = 16; // Holes per kernel call, and per tree leaf
+
+	void build(const std::vector<Rect> &holes);
+	void erase(size_t pos);
+	size_t size() const { return count_; }
+
+	// First position >= from of a hole at least w wide and h high, NONE if there is none
+	size_t first_fitting(size_t from, uint32_t w, uint32_t h) const;
+
+	// Visitors call f(pos) for each matching hole, in list order, f returns true to stop early.
+	// They return true if the visit was stopped.
+
+	// Holes that intersect area (sharing a common border is not considered an intersect)
+	template <typename F>
+	bool for_each_intersecting(const Rect &area, F &&f) const
+	{
+		return scan(Bounds{area.x2(), area.y2(), area.x(), area.y()}, f);
+	}
+
+	// Holes that contain (or are equal to) rect
+	template <typename F>
+	bool for_each_containing(const Rect &rect, F &&f) const
+	{
+		return scan(Bounds{rect.x() + 1, rect.y() + 1, rect.x2() - 1, rect.y2() - 1}, f);
+	}
+
+private:
+	// Holes with x < x_below, y < y_below, x2 > x2_above and y2 > y2_above
+	struct Bounds
+	{
+		uint32_t x_below, y_below, x2_above, y2_above;
+	};
+
+	// Padding and erased positions have x = UINT32_MAX and w = h = 0, they match nothing
+	std::vector<uint32_t> x_{}, y_{}, w_{}, h_{};
+	std::vector<uint32_t> max_w_{}; // Max width of node [lo, hi) of blocks, indexed like a heap
+	std::vector<uint32_t> max_h_{}; // Max height of node [lo, hi) of blocks, indexed like a heap
+	size_t leaves_ = 0;
+	size_t count_ = 0;
+
+	// Bit i is set if hole lane + i is within bounds
+	uint32_t bounds_mask(size_t lane, const Bounds &bounds) const;
+
+	size_t find_block(size_t node, size_t lo, size_t hi, size_t from, uint32_t w, uint32_t h) const;
+
+	template <typename F>
+	bool scan(const Bounds &bounds, F &f) const
+	{
+		// Holes are in y order, none from a lane starting at or below y_below matches
+		for (size_t lane = 0; lane < count_ && y_[lane] < bounds.y_below; lane += LANES)
+		{
+			for (uint32_t mask = bounds_mask(lane, bounds); mask != 0; mask &= mask - 1)
+			{
+				if (f(lane + __builtin_ctz(mask)))
+					return true;
+			}
+		}
+		return false;
+	}
+};
+
+#endif
@@ -0,0 +1,349 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : R-tree spatial index over holes
+ *                (Guttman R-tree, quadratic split)
+ *=============================================**/
+
+#include <tuple>
+#include <algorithm>
+
+#include "hole_index.h"
+
+// Area of a box, as double since holes reach INT_INFINITY in height
+static double box_area(uint32_t x, uint32_t y, uint32_t x2, uint32_t y2)
+{
+	return static_cast<double>(x2 - x) * static_cast<double>(y2 - y);
+}
+
+// Extra area needed for box a to also cover box b
+template <typename Box>
+static double enlargement(const Box &a, const Box &b)
+{
+	return box_area(std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x2, b.x2), std::max(a.y2, b.y2)) -
+		   box_area(a.x, a.y, a.x2, a.y2);
+}
+
+template <typename Box>
+static void extend(Box &a, const Box &b)
+{
+	a.x = std::min(a.x, b.x);
+	a.y = std::min(a.y, b.y);
+	a.x2 = std::max(a.x2, b.x2);
+	a.y2 = std::max(a.y2, b.y2);
+}
+
+void HoleIndex::clear()
+{
+	nodes_.clear();
+	free_nodes_.clear();
+	size_ = 0;
+	root_ = new_node(true);
+}
+
+uint32_t HoleIndex::new_node(bool leaf)
+{
+	uint32_t node;
+	if (!free_nodes_.empty())
+	{
+		node = free_nodes_.back();
+		free_nodes_.pop_back();
+	}
+	else
+	{
+		node = static_cast<uint32_t>(nodes_.size());
+		nodes_.emplace_back();
+	}
+	nodes_[node].count = 0;
+	nodes_[node].leaf = leaf;
+	return node;
+}
+
+HoleIndex::Box HoleIndex::node_box(uint32_t node) const
+{
+	const Node &n = nodes_[node];
+	Box box = n.entries[0].box;
+	for (uint32_t i = 1; i < n.count; ++i)
+	{
+		extend(box, n.entries[i].box);
+	}
+	return box;
+}
+
+void HoleIndex::insert(uint32_t id, const Rect &hole)
+{
+	insert_entry(Entry{to_box(hole), id});
+	size_++;
+}
+
+// Descend to the leaf needing the least enlargement, then split upwards on overflow
+void HoleIndex::insert_entry(const Entry &entry)
+{
+	path_.clear();
+	uint32_t node = root_;
+	while (!nodes_[node].leaf)
+	{
+		path_.push_back(node);
+
+		const Node &n = nodes_[node];
+		uint32_t best = 0;
+		double best_enlargement = 0, best_area = 0;
+		for (uint32_t i = 0; i < n.count; ++i)
+		{
+			const Box &b = n.entries[i].box;
+			double grow = enlargement(b, entry.box);
+			double area = box_area(b.x, b.y, b.x2, b.y2);
+			if (i == 0 || grow < best_enlargement || (grow == best_enlargement && area < best_area))
+			{
+				best = i;
+				best_enlargement = grow;
+				best_area = area;
+			}
+		}
+		node = n.entries[best].child;
+	}
+
+	bool has_sibling = false;
+	Entry sibling{};
+	if (nodes_[node].count < MAX_ENTRIES)
+	{
+		nodes_[node].entries[nodes_[node].count++] = entry;
+	}
+	else
+	{
+		split(node, entry, sibling);
+		has_sibling = true;
+	}
+
+	// Fix bounding boxes on the way up, adding split siblings to parents
+	while (!path_.empty())
+	{
+		uint32_t parent = path_.back();
+		path_.pop_back();
+
+		Node &p = nodes_[parent];
+		for (uint32_t i = 0; i < p.count; ++i)
+		{
+			if (p.entries[i].child == node)
+			{
+				p.entries[i].box = node_box(node);
+				break;
+			}
+		}
+
+		if (has_sibling)
+		{
+			if (p.count < MAX_ENTRIES)
+			{
+				p.entries[p.count++] = sibling;
+				has_sibling = false;
+			}
+			else
+			{
+				Entry carry = sibling;
+				split(parent, carry, sibling);
+			}
+		}
+		node = parent;
+	}
+
+	// Root was split, grow the tree by one level
+	if (has_sibling)
+	{
+		uint32_t old_root = root_;
+		root_ = new_node(false);
+		Node &r = nodes_[root_];
+		r.entries[0] = Entry{node_box(old_root), old_root};
+		r.entries[1] = sibling;
+		r.count = 2;
+	}
+}
+
+// Quadratic split of a full node plus one extra entry into node and a new sibling
+void HoleIndex::split(uint32_t node, const Entry &extra, Entry &sibling)
+{
+	constexpr uint32_t TOTAL = MAX_ENTRIES + 1;
+	Entry all[TOTAL];
+	std::copy(nodes_[node].entries, nodes_[node].entries + MAX_ENTRIES, all);
+	all[MAX_ENTRIES] = extra;
+
+	// Pick the two seeds that would waste the most area together
+	uint32_t seed_a = 0, seed_b = 1;
+	double worst = -1;
+	for (uint32_t i = 0; i < TOTAL; ++i)
+	{
+		for (uint32_t j = i + 1; j < TOTAL; ++j)
+		{
+			const Box &a = all[i].box;
+			const Box &b = all[j].box;
+			double waste = enlargement(a, b) - box_area(b.x, b.y, b.x2, b.y2);
+			if (waste > worst)
+			{
+				worst = waste;
+				seed_a = i;
+				seed_b = j;
+			}
+		}
+	}
+
+	bool leaf = nodes_[node].leaf;
+	uint32_t other = new_node(leaf); // may reallocate nodes_
+	Node &a = nodes_[node];
+	Node &b = nodes_[other];
+
+	a.entries[0] = all[seed_a];
+	a.count = 1;
+	b.entries[0] = all[seed_b];
+	b.count = 1;
+	Box box_a = all[seed_a].box;
+	Box box_b = all[seed_b].box;
+
+	bool assigned[TOTAL] = {};
+	assigned[seed_a] = assigned[seed_b] = true;
+	uint32_t remaining = TOTAL - 2;
+
+	while (remaining > 0)
+	{
+		// Keep both nodes at least MIN_ENTRIES full
+		if (a.count + remaining == MIN_ENTRIES || b.count + remaining == MIN_ENTRIES)
+		{
+			Node &target = (a.count + remaining == MIN_ENTRIES) ? a : b;
+			Box &target_box = (&target == &a) ? box_a : box_b;
+			for (uint32_t i = 0; i < TOTAL; ++i)
+			{
+				if (!assigned[i])
+				{
+					target.entries[target.count++] = all[i];
+					extend(target_box, all[i].box);
+				}
+			}
+			break;
+		}
+
+		// Next entry is the one with the strongest preference for a group
+		uint32_t next = 0;
+		double best_diff = -1, grow_a = 0, grow_b = 0;
+		for (uint32_t i = 0; i < TOTAL; ++i)
+		{
+			if (assigned[i])
+				continue;
+			double da = enlargement(box_a, all[i].box);
+			double db = enlargement(box_b, all[i].box);
+			double diff = da > db ? da - db : db - da;
+			if (diff > best_diff)
+			{
+				best_diff = diff;
+				next = i;
+				grow_a = da;
+				grow_b = db;
+			}
+		}
+
+		// Smallest enlargement, then smallest area, then fewest entries
+		double area_a = box_area(box_a.x, box_a.y, box_a.x2, box_a.y2);
+		double area_b = box_area(box_b.x, box_b.y, box_b.x2, box_b.y2);
+		bool to_a = std::make_tuple(grow_a, area_a, a.count) <= std::make_tuple(grow_b, area_b, b.count);
+		Node &target = to_a ? a : b;
+		target.entries[target.count++] = all[next];
+		extend(to_a ? box_a : box_b, all[next].box);
+		assigned[next] = true;
+		remaining--;
+	}
+
+	sibling = Entry{box_b, other};
+}
+
+// Records the path from node down to the leaf holding target in path_
+bool HoleIndex::find_leaf(uint32_t node, const Entry &target)
+{
+	path_.push_back(node);
+	const Node &n = nodes_[node];
+	for (uint32_t i = 0; i < n.count; ++i)
+	{
+		if (n.leaf)
+		{
+			if (n.entries[i].child == target.child)
+				return true;
+		}
+		else if (box_contains(n.entries[i].box, target.box) && find_leaf(n.entries[i].child, target))
+		{
+			return true;
+		}
+	}
+	path_.pop_back();
+	return false;
+}
+
+// Frees a subtree, keeping its leaf entries in orphans_ for reinsertion
+void HoleIndex::collect_leaf_entries(uint32_t node)
+{
+	const Node &n = nodes_[node];
+	for (uint32_t i = 0; i < n.count; ++i)
+	{
+		if (n.leaf)
+			orphans_.push_back(n.entries[i]);
+		else
+			collect_leaf_entries(n.entries[i].child);
+	}
+	free_nodes_.push_back(node);
+}
+
+void HoleIndex::remove(uint32_t id, const Rect &hole)
+{
+	Entry target{to_box(hole), id};
+
+	path_.clear();
+	if (!find_leaf(root_, target))
+		return;
+
+	Node &leaf = nodes_[path_.back()];
+	for (uint32_t i = 0; i < leaf.count; ++i)
+	{
+		if (leaf.entries[i].child == target.child)
+		{
+			leaf.entries[i] = leaf.entries[--leaf.count];
+			break;
+		}
+	}
+	size_--;
+
+	// Condense: drop underfull nodes, tighten boxes of the others
+	orphans_.clear();
+	for (size_t k = path_.size() - 1; k > 0; --k)
+	{
+		uint32_t node = path_[k];
+		Node &parent = nodes_[path_[k - 1]];
+		for (uint32_t i = 0; i < parent.count; ++i)
+		{
+			if (parent.entries[i].child != node)
+				continue;
+
+			if (nodes_[node].count < MIN_ENTRIES)
+			{
+				parent.entries[i] = parent.entries[--parent.count];
+				collect_leaf_entries(node);
+			}
+			else
+			{
+				parent.entries[i].box = node_box(node);
+			}
+			break;
+		}
+	}
+
+	// Shorten the tree while the root only has one child
+	while (!nodes_[root_].leaf && nodes_[root_].count == 1)
+	{
+		free_nodes_.push_back(root_);
+		root_ = nodes_[root_].entries[0].child;
+	}
+	if (nodes_[root_].count == 0)
+	{
+		nodes_[root_].leaf = true;
+	}
+
+	for (size_t i = 0; i < orphans_.size(); ++i)
+	{
+		insert_entry(orphans_[i]);
+	}
+}
@@ -0,0 +1,115 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : R-tree spatial index over holes,
+ *                keyed on their x/y extents
+ *=============================================**/
+
+#ifndef HOLE_INDEX_H
+#define HOLE_INDEX_H
+
+#include "../types.h"
+
+/**============================================
+ *    HoleIndex (R-tree, quadratic split)
+ * Stores hole ids with their bounding boxes and
+ * answers "which holes intersect this rectangle"
+ * (containment queries go to DominanceIndex).
+ * Hole ids must be unique while indexed.
+ *=============================================**/
+class HoleIndex
+{
+public:
+	HoleIndex() { clear(); }
+
+	void clear();
+	void insert(uint32_t id, const Rect &hole);
+	void remove(uint32_t id, const Rect &hole);
+	size_t size() const { return size_; }
+
+	// Visitors call f(id, hole) for each matching hole, f returns true to stop early.
+	// They return true if the visit was stopped.
+
+	// Holes that intersect area (sharing a common border is not considered an intersect)
+	template <typename F>
+	bool for_each_intersecting(const Rect &area, F &&f) const
+	{
+		Box box = to_box(area);
+		auto overlaps = [&box](const Box &b)
+		{ return box_intersects(b, box); };
+		return size_ != 0 && visit(root_, overlaps, overlaps, f);
+	}
+
+private:
+	static constexpr uint32_t MAX_ENTRIES = 8;
+	static constexpr uint32_t MIN_ENTRIES = 3;
+
+	struct Box
+	{
+		uint32_t x, y, x2, y2;
+	};
+
+	struct Entry
+	{
+		Box box;
+		uint32_t child; // hole id in leaves, node index otherwise
+	};
+
+	struct Node
+	{
+		Entry entries[MAX_ENTRIES];
+		uint32_t count = 0;
+		bool leaf = true;
+	};
+
+	std::vector<Node> nodes_{};
+	std::vector<uint32_t> free_nodes_{};
+	std::vector<uint32_t> path_{};
+	std::vector<Entry> orphans_{};
+	uint32_t root_ = 0;
+	size_t size_ = 0;
+
+	uint32_t new_node(bool leaf);
+	Box node_box(uint32_t node) const;
+	void insert_entry(const Entry &entry);
+	void split(uint32_t node, const Entry &extra, Entry &sibling);
+	bool find_leaf(uint32_t node, const Entry &target);
+	void collect_leaf_entries(uint32_t node);
+
+	static Box to_box(const Rect &rect)
+	{
+		return Box{rect.x(), rect.y(), rect.x2(), rect.y2()};
+	}
+
+	static Rect to_rect(const Box &box)
+	{
+		return Rect(box.x, box.y, box.x2 - box.x, box.y2 - box.y);
+	}
+
+	static bool box_intersects(const Box &a, const Box &b)
+	{
+		return a.x < b.x2 && a.x2 > b.x && a.y < b.y2 && a.y2 > b.y;
+	}
+
+	static bool box_contains(const Box &a, const Box &b)
+	{
+		return a.x <= b.x && a.y <= b.y && a.x2 >= b.x2 && a.y2 >= b.y2;
+	}
+
+	// Depth-first search, descending into subtrees whose box passes
+	// descend and reporting leaf entries whose box passes match
+	template <typename Descend, typename Match, typename F>
+	bool visit(uint32_t node, Descend &descend, Match &match, F &f) const
+	{
+		const Node &n = nodes_[node];
+		for (uint32_t i = 0; i < n.count; ++i)
+		{
+			const Entry &e = n.entries[i];
+			if (n.leaf ? (match(e.box) && f(e.child, to_rect(e.box))) : (descend(e.box) && visit(e.child, descend, match, f)))
+				return true;
+		}
+		return false;
+	}
+};
+
+#endif
@@ -0,0 +1,586 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Reads instance files straight
+ *                from memory-mapped bytes
+ *=============================================**/
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <charconv>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define LOADER_MMAP 1
+#else
+#define LOADER_MMAP 0
+#endif
+
+#include "loader.h"
+#include "thread_pool.h"
+
+constexpr size_t MIN_CHUNK_BYTES = 1 << 20;	 // Smaller texts aren't worth splitting between threads
+constexpr size_t READ_BUFFER_BYTES = 1 << 16; // Text read_rectangles holds at most
+
+/**============================================
+ *                MappedFile
+ *=============================================**/
+MappedFile::MappedFile(const std::string &path)
+{
+#if LOADER_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("Couldn't open file " + path + ": " + std::strerror(errno));
+	struct stat info{};
+	if (::fstat(fd, &info) != 0)
+	{
+		int error = errno;
+		::close(fd);
+		throw std::runtime_error("Couldn't read file " + path + ": " + std::strerror(error));
+	}
+	size_ = info.st_size;
+
+	// Empty files can't be mapped, and have nothing to map
+	if (size_ != 0)
+	{
+		void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			int error = errno;
+			::close(fd);
+			throw std::runtime_error("Couldn't map file " + path + ": " + std::strerror(error));
+		}
+		::madvise(data, size_, MADV_SEQUENTIAL);
+		data_ = static_cast<const char *>(data);
+		mapped_ = true;
+	}
+	::close(fd);
+#else
+	std::ifstream ifs(path, std::ios::binary);
+	if (!ifs.is_open())
+		throw std::runtime_error("Couldn't open file " + path + ": " + std::strerror(errno));
+	buffer_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+#endif
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+	: data_(other.data_), size_(other.size_), mapped_(other.mapped_), buffer_(std::move(other.buffer_))
+{
+	other.data_ = nullptr;
+	other.size_ = 0;
+	other.mapped_ = false;
+}
+
+MappedFile::~MappedFile()
+{
+#if LOADER_MMAP
+	if (mapped_)
+		::munmap(const_cast<char *>(data_), size_);
+#endif
+}
+
+/**============================================
+ *                  Parsing
+ *=============================================**/
+static bool is_blank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Appends the rectangles of [p, end), which starts at a line start, to rectangles, ids counting from 1.
+// A comma can stand between w and h. Returns the start of the first bad line, or nullptr
+static const char *parse_chunk(const char *p, const char *end, std::vector<Shape> &rectangles)
+{
+	while (p < end)
+	{
+		const char *line = p;
+		while (p < end && is_blank(*p))
+			++p;
+		if (p < end && *p == '\n')
+		{
+			++p;
+			continue;
+		}
+		if (p == end)
+			break;
+
+		uint32_t w, h;
+		std::from_chars_result parsed = std::from_chars(p, end, w);
+		if (parsed.ec != std::errc() || parsed.ptr == end || !(is_blank(*parsed.ptr) || *parsed.ptr == ','))
+			return line;
+		p = parsed.ptr;
+		while (p < end && is_blank(*p))
+			++p;
+		if (p < end && *p == ',')
+		{
+			++p;
+			while (p < end && is_blank(*p))
+				++p;
+		}
+		parsed = std::from_chars(p, end, h);
+		if (parsed.ec != std::errc())
+			return line;
+		p = parsed.ptr;
+		while (p < end && is_blank(*p))
+			++p;
+		if (p < end && *p++ != '\n')
+			return line;
+
+		rectangles.emplace_back(rectangles.size() + 1, 0, 0, w, h);
+	}
+	return nullptr;
+}
+
+// parse_rectangles of text whose first line is line first_line of source
+static std::vector<Shape> parse_lines(const char *begin, const char *end, size_t first_line, const std::string &source, ThreadPool *pool)
+{
+	// Chunks end just after a newline, so that each one starts at a line start
+	size_t size = end - begin;
+	size_t chunks = pool ? std::max<size_t>(1, std::min(pool->size(), size / MIN_CHUNK_BYTES)) : 1;
+	std::vector<const char *> bounds{begin};
+	for (size_t c = 1; c < chunks; ++c)
+	{
+		const char *at = std::max(bounds.back(), begin + size * c / chunks);
+		const char *newline = static_cast<const char *>(std::memchr(at, '\n', end - at));
+		if (newline == nullptr)
+			break;
+		bounds.push_back(newline + 1);
+	}
+	bounds.push_back(end);
+	chunks = bounds.size() - 1;
+
+	// Each chunk reserves for one rectangle per line, then parses into its own vector
+	std::vector<std::vector<Shape>> parts(chunks);
+	std::vector<const char *> bad_lines(chunks, nullptr);
+	auto parse_part = [&](size_t c)
+	{
+		parts[c].reserve(std::count(bounds[c], bounds[c + 1], '\n') + 1);
+		bad_lines[c] = parse_chunk(bounds[c], bounds[c + 1], parts[c]);
+	};
+	if (chunks == 1)
+	{
+		parse_part(0);
+	}
+	else
+	{
+		for (size_t c = 0; c < chunks; ++c)
+		{
+			pool->submit([&parse_part, c]()
+						 { parse_part(c); });
+		}
+		pool->wait();
+	}
+
+	for (const char *bad_line : bad_lines)
+	{
+		if (bad_line == nullptr)
+			continue;
+		size_t line = std::count(begin, bad_line, '\n') + first_line;
+		throw std::runtime_error("Bad rectangle on line " + std::to_string(line) + " of " + source + ", expected <w> <h>");
+	}
+
+	if (chunks == 1)
+		return std::move(parts[0]);
+
+	// Ids follow the line order across chunks
+	size_t count = 0;
+	for (const std::vector<Shape> &part : parts)
+	{
+		count += part.size();
+	}
+	std::vector<Shape> rectangles;
+	rectangles.reserve(count);
+	for (std::vector<Shape> &part : parts)
+	{
+		uint32_t first_id = rectangles.size();
+		for (const Shape &rectangle : part)
+		{
+			rectangles.emplace_back(first_id + rectangle.id(), rectangle.rect(), false);
+		}
+		std::vector<Shape>().swap(part);
+	}
+	return rectangles;
+}
+
+std::vector<Shape> parse_rectangles(const char *begin, const char *end, const std::string &source, ThreadPool *pool)
+{
+	return parse_lines(begin, end, 1, source, pool);
+}
+
+std::vector<Shape> load_rectangles(const std::string &path, ThreadPool *pool)
+{
+	MappedFile file(path);
+	return parse_rectangles(file.data(), file.data() + file.size(), path, pool);
+}
+
+void read_rectangles(std::istream &in, const std::string &source, const std::function<void(const Shape &rectangle)> &on_rectangle)
+{
+	std::vector<char> buffer(READ_BUFFER_BYTES);
+	std::vector<Shape> rectangles;
+	size_t used = 0;
+	size_t lines = 0;	// Before the buffer
+	uint32_t count = 0; // Rectangles before the buffer
+
+	auto parse = [&](const char *end)
+	{
+		const char *begin = buffer.data();
+		rectangles.clear();
+		const char *bad_line = parse_chunk(begin, end, rectangles);
+		if (bad_line != nullptr)
+		{
+			size_t line = lines + std::count(begin, bad_line, '\n') + 1;
+			throw std::runtime_error("Bad rectangle on line " + std::to_string(line) + " of " + source + ", expected <w> <h>");
+		}
+		for (const Shape &rectangle : rectangles)
+		{
+			on_rectangle(Shape(count + rectangle.id(), rectangle.rect(), false));
+		}
+		count += rectangles.size();
+		lines += std::count(begin, end, '\n');
+	};
+
+	// peek waits for input, readsome then takes what has arrived without waiting for more
+	while (in.peek() != std::char_traits<char>::eof())
+	{
+		if (used == buffer.size())
+			throw std::runtime_error("Line " + std::to_string(lines + 1) + " of " + source + " is too long for a rectangle");
+		std::streamsize got = in.readsome(buffer.data() + used, buffer.size() - used);
+		if (got == 0)
+		{
+			// Streams that can't tell what they hold (std::cin synced with stdio) give a byte at a time
+			in.get(buffer[used]);
+			got = 1;
+		}
+		used += got;
+
+		// Complete lines are parsed, the rest waits for its end
+		const char *end = buffer.data() + used;
+		while (end != buffer.data() && end[-1] != '\n')
+			--end;
+		if (end == buffer.data())
+			continue;
+		parse(end);
+		size_t rest = buffer.data() + used - end;
+		std::memmove(buffer.data(), end, rest);
+		used = rest;
+	}
+	if (in.bad())
+		throw std::runtime_error("Couldn't read " + source);
+	if (used != 0)
+		parse(buffer.data() + used);
+}
+
+/**============================================
+ *              Binary instances
+ *=============================================**/
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Binary instances are read in place, which needs a little-endian target"
+#endif
+
+BinaryInstance::BinaryInstance(const std::string &path) : BinaryInstance(MappedFile(path), path) {}
+
+BinaryInstance::BinaryInstance(MappedFile file, const std::string &source) : file_(std::move(file))
+{
+	if (!is_binary(file_))
+		throw std::runtime_error(source + " is not a binary instance");
+	std::memcpy(&header_, file_.data(), sizeof(header_));
+	if (header_.version != 1)
+		throw std::runtime_error(source + " has binary instance version " + std::to_string(header_.version) + ", only 1 is known");
+	if ((file_.size() - sizeof(header_)) / (2 * sizeof(uint32_t)) < header_.N)
+		throw std::runtime_error(source + " is shorter than its " + std::to_string(header_.N) + " rectangles");
+	if (header_.N > UINT32_MAX)
+		throw std::runtime_error(source + " has more rectangles than ids");
+	sizes_ = reinterpret_cast<const uint32_t *>(file_.data() + sizeof(header_));
+}
+
+bool BinaryInstance::is_binary(const MappedFile &file)
+{
+	return file.size() >= sizeof(BinaryHeader) && std::memcmp(file.data(), BinaryHeader{}.magic, sizeof(BinaryHeader::magic)) == 0;
+}
+
+std::vector<Shape> BinaryInstance::rectangles() const
+{
+	std::vector<Shape> rectangles;
+	rectangles.reserve(header_.N);
+	for (size_t i = 0; i < header_.N; ++i)
+	{
+		rectangles.emplace_back(i + 1, 0, 0, w(i), h(i));
+	}
+	return rectangles;
+}
+
+void write_binary_instance(std::ostream &os, uint32_t W, const std::vector<Shape> &rectangles, uint32_t known_h)
+{
+	BinaryHeader header{};
+	header.W = W;
+	header.known_h = known_h;
+	header.N = rectangles.size();
+	os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	std::vector<uint32_t> sizes;
+	sizes.reserve(2 * rectangles.size());
+	for (const Shape &rectangle : rectangles)
+	{
+		sizes.push_back(rectangle.w());
+		sizes.push_back(rectangle.h());
+	}
+	os.write(reinterpret_cast<const char *>(sizes.data()), sizes.size() * sizeof(uint32_t));
+}
+
+/**============================================
+ *                 Instance
+ *=============================================**/
+// The number after the first tag in the file's name that is followed by digits then _ or the name's end, 0 if none
+static uint32_t number_from_name(const std::string &path, const std::string &tag)
+{
+	std::string name = std::filesystem::path(path).stem().string();
+	for (size_t at = name.find(tag); at != std::string::npos; at = name.find(tag, at + 1))
+	{
+		uint32_t value = 0;
+		size_t digit = at + tag.size();
+		while (digit < name.size() && name[digit] >= '0' && name[digit] <= '9')
+		{
+			value = value * 10 + (name[digit++] - '0');
+		}
+		if (digit > at + tag.size() && (digit == name.size() || name[digit] == '_'))
+			return value;
+	}
+	return 0;
+}
+
+uint32_t width_from_name(const std::string &path)
+{
+	return number_from_name(path, "_W");
+}
+
+uint32_t optimum_from_name(const std::string &path)
+{
+	uint32_t optimum = number_from_name(path, "_OPTH");
+	return optimum != 0 ? optimum : number_from_name(path, "_OPT");
+}
+
+std::pair<std::string, uint32_t> split_problem(const std::string &path)
+{
+	size_t colon = path.find_last_of(':');
+	if (colon == std::string::npos || colon == 0 || colon + 1 == path.size() ||
+		path.find_first_not_of("0123456789", colon + 1) != std::string::npos || std::filesystem::exists(path))
+		return {path, 0};
+	uint32_t problem = 0;
+	std::from_chars(path.data() + colon + 1, path.data() + path.size(), problem);
+	return {path.substr(0, colon), problem};
+}
+
+/**============================================
+ *              Corpus formats
+ * Text instances come in three layouts, told
+ * apart by their first line that isn't blank:
+ * - <w> <h> lines, W and the optimum only in the
+ *   name (gcut1_W250.txt, 10_W60_OPTH60.txt, the
+ *   beng .lst files)
+ * - a <W> line, then <h>,<w> lines (ngcut: the
+ *   width comes second, it is the one never
+ *   wider than W)
+ * - OR-Lib 2D packing: a problem count, then for
+ *   each problem its bins (a count, then W H for
+ *   each) and item types (a count, then w h, two
+ *   unused numbers and the copies for each). The
+ *   first bin gives W and the optimal height.
+ * The last two both start with a single number:
+ * a file is OR-Lib if all of its numbers follow
+ * that layout, to the end.
+ *=============================================**/
+static bool is_space(char c)
+{
+	return is_blank(c) || c == '\n';
+}
+
+// The first line that isn't blank: where it starts and ends, its line number and how many numbers
+// (separated by blanks or commas) it holds, counting anything else as a third one
+struct FirstLine
+{
+	const char *begin = nullptr;
+	const char *end = nullptr;
+	size_t number = 1;
+	size_t numbers = 0;
+	uint32_t first = 0;
+};
+
+static FirstLine first_line(const char *p, const char *end)
+{
+	FirstLine line{};
+	while (true)
+	{
+		const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+		line.begin = p;
+		line.end = newline ? newline : end;
+		while (p < line.end && is_blank(*p))
+			++p;
+		if (p < line.end || newline == nullptr)
+			break;
+		p = newline + 1;
+		line.number++;
+	}
+
+	while (p < line.end && line.numbers < 3)
+	{
+		uint32_t value = 0;
+		std::from_chars_result parsed = std::from_chars(p, line.end, value);
+		if (parsed.ec != std::errc())
+		{
+			line.numbers = 3;
+			break;
+		}
+		if (line.numbers++ == 0)
+			line.first = value;
+		p = parsed.ptr;
+		while (p < line.end && (is_blank(*p) || *p == ','))
+			++p;
+	}
+	return line;
+}
+
+// The problems of an OR-Lib file, none if the text doesn't follow that layout to its end
+static std::vector<Instance> parse_orlib(const char *p, const char *end)
+{
+	std::vector<uint64_t> numbers;
+	while (true)
+	{
+		while (p < end && is_space(*p))
+			++p;
+		if (p == end)
+			break;
+		uint64_t value = 0;
+		std::from_chars_result parsed = std::from_chars(p, end, value);
+		if (parsed.ec != std::errc() || (parsed.ptr != end && !is_space(*parsed.ptr)))
+			return {};
+		numbers.push_back(value);
+		p = parsed.ptr;
+	}
+
+	size_t at = 0;
+	auto take = [&numbers, &at](uint64_t &value, uint64_t max)
+	{
+		if (at == numbers.size() || numbers[at] > max)
+			return false;
+		value = numbers[at++];
+		return true;
+	};
+
+	std::vector<Instance> problems;
+	uint64_t count = 0;
+	if (!take(count, numbers.size()) || count == 0)
+		return {};
+	for (uint32_t problem = 1; problem <= count; ++problem)
+	{
+		Instance instance{};
+		instance.problem = problem;
+		uint64_t bins = 0, W = 0, H = 0, types = 0;
+		if (!take(bins, numbers.size()) || bins == 0 || !take(W, UINT32_MAX) || !take(H, UINT32_MAX))
+			return {};
+		at += 2 * (bins - 1);
+		if (at > numbers.size() || !take(types, numbers.size()))
+			return {};
+		instance.W = W;
+		instance.known_h = H;
+
+		for (uint64_t type = 0; type < types; ++type)
+		{
+			uint64_t w = 0, h = 0, unused = 0, copies = 0;
+			if (!take(w, UINT32_MAX) || !take(h, UINT32_MAX) || !take(unused, UINT64_MAX) || !take(unused, UINT64_MAX) ||
+				!take(copies, UINT32_MAX - instance.rectangles.size()))
+				return {};
+			for (uint64_t copy = 0; copy < copies; ++copy)
+			{
+				instance.rectangles.emplace_back(instance.rectangles.size() + 1, 0, 0, w, h);
+			}
+		}
+		problems.push_back(std::move(instance));
+	}
+	if (at != numbers.size())
+		return {};
+	return problems;
+}
+
+// The instances of a text file, W and the optimum coming from the name unless the text gives them
+static std::vector<Instance> parse_text(const char *begin, const char *end, const std::string &path, ThreadPool *pool)
+{
+	Instance instance{};
+	instance.W = width_from_name(path);
+	instance.known_h = optimum_from_name(path);
+
+	FirstLine line = first_line(begin, end);
+	if (line.numbers != 1)
+	{
+		instance.rectangles = parse_lines(begin, end, 1, path, pool);
+		return {instance};
+	}
+
+	std::vector<Instance> problems = parse_orlib(begin, end);
+	if (!problems.empty())
+		return problems;
+
+	instance.W = line.first;
+	const char *rest = line.end == end ? end : line.end + 1;
+	instance.rectangles = parse_lines(rest, end, line.number + 1, path, pool);
+	for (Shape &rectangle : instance.rectangles)
+	{
+		rectangle = Shape(rectangle.id(), 0, 0, rectangle.h(), rectangle.w());
+	}
+	return {instance};
+}
+
+std::vector<Instance> load_instances(const std::string &path, ThreadPool *pool)
+{
+	MappedFile file(path);
+	if (!BinaryInstance::is_binary(file))
+		return parse_text(file.data(), file.data() + file.size(), path, pool);
+
+	Instance instance{};
+	BinaryInstance binary(std::move(file), path);
+	instance.W = binary.header().W;
+	instance.known_h = binary.header().known_h;
+	instance.rectangles = binary.rectangles();
+	return {instance};
+}
+
+Instance load_instance(const std::string &path, ThreadPool *pool)
+{
+	auto [file, problem] = split_problem(path);
+	std::vector<Instance> instances = load_instances(file, pool);
+	if (problem != 0)
+	{
+		if (problem > instances.size() || instances[problem - 1].problem != problem)
+			throw std::runtime_error(file + " has no problem " + std::to_string(problem));
+		return std::move(instances[problem - 1]);
+	}
+	if (instances.size() != 1)
+		throw std::runtime_error(file + " holds " + std::to_string(instances.size()) + " problems, pick one as " + file + ":<problem>");
+	return std::move(instances.front());
+}
+
+std::vector<std::string> instance_paths(const std::string &path)
+{
+	// Only a text file starting with a single number can hold several problems
+	MappedFile file(path);
+	if (BinaryInstance::is_binary(file) || first_line(file.data(), file.data() + file.size()).numbers != 1)
+		return {path};
+	std::vector<Instance> problems = parse_orlib(file.data(), file.data() + file.size());
+	if (problems.size() <= 1)
+		return {path};
+
+	std::vector<std::string> paths;
+	for (const Instance &problem : problems)
+	{
+		paths.push_back(path + ":" + std::to_string(problem.problem));
+	}
+	return paths;
+}
@@ -0,0 +1,137 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Reads instance files straight
+ *                from memory-mapped bytes
+ *=============================================**/
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <string>
+#include <ostream>
+#include <istream>
+#include <utility>
+#include <functional>
+
+#include "../types.h"
+
+class ThreadPool;
+
+/**============================================
+ *                MappedFile
+ * A file's bytes, read only. Memory-mapped where
+ * the platform has mmap, else read into memory.
+ *=============================================**/
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string &path); // Throws if the file can't be read
+	MappedFile(MappedFile &&other) noexcept;
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const char *data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	const char *data_ = nullptr;
+	size_t size_ = 0;
+	bool mapped_ = false;
+	std::vector<char> buffer_{}; // The bytes when they aren't mapped
+};
+
+// Rectangles of text with a <w> <h> (or <w>,<h>) line per rectangle, ids from 1 in line order. Blank
+// lines are skipped, any other line that isn't two numbers throws, naming source and the line.
+// With a pool, large texts are parsed in chunks split at line ends, one per thread
+std::vector<Shape> parse_rectangles(const char *begin, const char *end, const std::string &source, ThreadPool *pool = nullptr);
+
+// parse_rectangles over a memory-mapped file
+std::vector<Shape> load_rectangles(const std::string &path, ThreadPool *pool = nullptr);
+
+// Reads <w> <h> lines from in as they arrive (a pipe doesn't have to fill a buffer first) and hands
+// each rectangle to on_rectangle, ids from 1 in line order. Bad lines throw as in parse_rectangles.
+// Holds a buffer's worth of text at a time, however long the input
+void read_rectangles(std::istream &in, const std::string &source, const std::function<void(const Shape &rectangle)> &on_rectangle);
+
+/**============================================
+ *              Binary instances
+ * A 24-byte header, then a (w, h) pair of u32 per
+ * rectangle, all little-endian:
+ *   "SPPI" | version u32 | W u32 | known_h u32 | N u64
+ * known_h is the optimal height if known, else 0.
+ * The pairs start 8-byte aligned, so a mapped file
+ * is read in place without parsing.
+ *=============================================**/
+struct BinaryHeader
+{
+	char magic[4] = {'S', 'P', 'P', 'I'};
+	uint32_t version = 1;
+	uint32_t W = 0;
+	uint32_t known_h = 0;
+	uint64_t N = 0;
+};
+
+static_assert(sizeof(BinaryHeader) == 24, "BinaryHeader is the 24-byte file header");
+
+// A mapped binary instance, its sizes read straight from the file
+class BinaryInstance
+{
+public:
+	// Throw if the file isn't a binary instance, source names it in errors
+	explicit BinaryInstance(const std::string &path);
+	BinaryInstance(MappedFile file, const std::string &source);
+	static bool is_binary(const MappedFile &file);
+
+	const BinaryHeader &header() const { return header_; }
+	uint32_t w(size_t i) const { return sizes_[2 * i]; }
+	uint32_t h(size_t i) const { return sizes_[2 * i + 1]; }
+
+	std::vector<Shape> rectangles() const; // Ids from 1 in file order
+
+private:
+	MappedFile file_;
+	BinaryHeader header_{};
+	const uint32_t *sizes_ = nullptr;
+};
+
+void write_binary_instance(std::ostream &os, uint32_t W, const std::vector<Shape> &rectangles, uint32_t known_h = 0);
+
+/**============================================
+ *                 Instance
+ * What a file says about an instance: W and the
+ * known optimum come from a binary header, from
+ * the text (ngcut, OR-Lib, see loader.cpp), else
+ * from _W<width> and _OPTH<height> in the file's
+ * name, and are 0 when the file doesn't say.
+ * An OR-Lib file holds several problems, each an
+ * instance, named <file>:<problem> from 1.
+ *=============================================**/
+struct Instance
+{
+	uint32_t W = 0;
+	uint32_t known_h = 0;
+	std::vector<Shape> rectangles{};
+	uint32_t problem = 0; // In a file of several problems, from 1, else 0
+};
+
+// Strip width from a file name such as gcut1_W250.txt or 10_W60_OPTH60.txt, 0 if it has none
+uint32_t width_from_name(const std::string &path);
+
+// Optimal height from a file name such as 10_W60_OPTH60.txt (or _OPT60), 0 if it has none
+uint32_t optimum_from_name(const std::string &path);
+
+// Splits <file>:<problem> into the file and the problem, which is 0 if path names a whole file
+std::pair<std::string, uint32_t> split_problem(const std::string &path);
+
+// Every instance in a file: binary and text instances hold one, OR-Lib files one per problem
+std::vector<Instance> load_instances(const std::string &path, ThreadPool *pool = nullptr);
+
+// The instance at path, which may pick a problem as <file>:<problem>. Throws if it holds several and none is picked
+Instance load_instance(const std::string &path, ThreadPool *pool = nullptr);
+
+// What load_instance takes for each instance in a file: the file, or <file>:<problem> for each of several
+std::vector<std::string> instance_paths(const std::string &path);
+
+#endif
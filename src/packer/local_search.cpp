@@ -0,0 +1,242 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Local search over the order
+ *                rectangles are placed in
+ *=============================================**/
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include "local_search.h"
+#include "packer.h"
+#include "lower_bound.h"
+
+constexpr uint32_t MIN_CHECKPOINT_INTERVAL = 16;
+constexpr uint32_t MAX_CHECKPOINTS = 32; // Each keeps a hole list alive, the placed rectangles are shared
+
+enum class Orientation : uint8_t
+{
+	Free,	 // Rotated if rotations are allowed and that fits better
+	AsIs,	 // Never rotated
+	Rotated, // Always rotated
+};
+
+// A rectangle of the sequence
+struct Item
+{
+	uint32_t index; // In the input
+	Orientation orientation;
+};
+
+enum class MoveKind : uint8_t
+{
+	Swap,	// Exchange the items at from and to
+	Insert, // Take the item at from out and put it back at to
+	Flip,	// Item at from goes from a free orientation to the other one it is placed in, or back to free
+};
+
+struct Move
+{
+	MoveKind kind;
+	uint32_t from, to;
+
+	uint32_t first_changed() const { return kind == MoveKind::Flip ? from : std::min(from, to); }
+};
+
+/**============================================
+ *              SequenceSearch
+ * The current sequence, its packing and its
+ * checkpoints: checkpoints_[c] is the state
+ * after the first c * interval placements.
+ *=============================================**/
+class SequenceSearch
+{
+public:
+	SequenceSearch(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, uint32_t interval)
+		: rectangles_(rectangles), rotations_(rotations), interval_(interval), packer_(W)
+	{
+		current_.resize(rectangles.size());
+		for (uint32_t i = 0; i < rectangles.size(); ++i)
+		{
+			current_[i] = Item{i, Orientation::Free};
+		}
+		checkpoints_.resize(std::max<size_t>(1, (rectangles.size() + interval - 1) / interval));
+		candidate_checkpoints_.resize(checkpoints_.size());
+
+		checkpoints_[0] = packer_.checkpoint();
+		replay(current_, 0, UINT32_MAX, checkpoints_);
+		height_ = packer_.height();
+		placed_ = packer_.rectangles();
+	}
+
+	// Keeps move if the sequence it gives is no higher than the current one
+	bool try_move(const Move &move)
+	{
+		candidate_ = current_;
+		if (!apply(candidate_, move))
+			return false;
+
+		uint32_t first = move.first_changed();
+		if (!replay(candidate_, first, height_, candidate_checkpoints_))
+			return false;
+
+		// The checkpoints the replay went past now hold the candidate's states
+		for (size_t c = first / interval_ + 1; c < checkpoints_.size(); ++c)
+		{
+			std::swap(checkpoints_[c], candidate_checkpoints_[c]);
+		}
+		std::swap(current_, candidate_);
+		height_ = packer_.height();
+		placed_ = packer_.rectangles();
+		return true;
+	}
+
+	uint32_t height() const { return height_; }
+	const std::vector<Item> &sequence() const { return current_; }
+	const PrefixVector<Shape> &placed() const { return placed_; } // placed()[i] is sequence()[i] as placed
+
+private:
+	const std::vector<Shape> &rectangles_;
+	bool rotations_;
+	uint32_t interval_;
+	Packer packer_;
+
+	std::vector<Item> current_{};
+	std::vector<Item> candidate_{};
+	std::vector<PackerCheckpoint> checkpoints_{};
+	std::vector<PackerCheckpoint> candidate_checkpoints_{}; // Filled while replaying a candidate
+	PrefixVector<Shape> placed_{}; // Shared with the packer's state, not copied
+	uint32_t height_ = 0;
+
+	// False if the move can't be made
+	bool apply(std::vector<Item> &sequence, const Move &move) const
+	{
+		switch (move.kind)
+		{
+		case MoveKind::Swap:
+			std::swap(sequence[move.from], sequence[move.to]);
+			return true;
+		case MoveKind::Insert:
+			if (move.from < move.to)
+				std::rotate(sequence.begin() + move.from, sequence.begin() + move.from + 1, sequence.begin() + move.to + 1);
+			else
+				std::rotate(sequence.begin() + move.to, sequence.begin() + move.from, sequence.begin() + move.from + 1);
+			return true;
+		case MoveKind::Flip:
+		{
+			Item &item = sequence[move.from];
+			if (item.orientation != Orientation::Free)
+			{
+				item.orientation = Orientation::Free;
+				return true;
+			}
+			// Force the orientation it isn't placed in, if it fits in the strip that way
+			const Shape &rectangle = rectangles_[item.index];
+			bool rotated = placed_[move.from].is_rotated();
+			item.orientation = rotated ? Orientation::AsIs : Orientation::Rotated;
+			return (rotated ? rectangle.w() : rectangle.h()) <= packer_.width();
+		}
+		}
+		return false;
+	}
+
+	// Packs sequence from the last checkpoint at or before first, saving the states
+	// it goes past into checkpoints. Returns false as soon as the height passes bound
+	bool replay(const std::vector<Item> &sequence, uint32_t first, uint32_t bound, std::vector<PackerCheckpoint> &checkpoints)
+	{
+		size_t c = first / interval_;
+		packer_.restore(checkpoints_[c]);
+
+		for (size_t pos = c * interval_; pos < sequence.size(); ++pos)
+		{
+			if (pos % interval_ == 0 && pos / interval_ > c)
+				checkpoints[pos / interval_] = packer_.checkpoint();
+
+			const Item &item = sequence[pos];
+			const Shape &rectangle = rectangles_[item.index];
+			switch (item.orientation)
+			{
+			case Orientation::Free:
+				packer_.place(rectangle.w(), rectangle.h(), rotations_);
+				break;
+			case Orientation::AsIs:
+				packer_.place(rectangle.w(), rectangle.h(), false);
+				break;
+			case Orientation::Rotated:
+				packer_.place(rectangle.h(), rectangle.w(), false);
+				break;
+			}
+			if (packer_.height() > bound)
+				return false;
+		}
+		return true;
+	}
+};
+
+Result local_search(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy, const LocalSearchOptions &options)
+{
+	auto start_time = std::chrono::high_resolution_clock::now();
+	auto deadline = start_time + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(options.time_limit));
+
+	uint32_t N = rectangles.size();
+	uint32_t interval = options.checkpoint_interval;
+	if (interval == 0)
+		interval = std::max({MIN_CHECKPOINT_INTERVAL, static_cast<uint32_t>(std::sqrt(static_cast<double>(N))), (N + MAX_CHECKPOINTS - 1) / MAX_CHECKPOINTS});
+
+	// Start from the heuristic's order, items index into it
+	std::vector<Shape> sorted(rectangles.begin(), rectangles.end());
+	sort_by_heuristic(sorted, strategy);
+	SequenceSearch search(W, sorted, rotations, interval);
+	uint32_t bound = height_lower_bound(W, rectangles, rotations).value;
+
+	std::mt19937_64 engine(options.seed);
+	uint32_t kinds = rotations ? 3 : 2;
+	bool can_move = N >= 2 || (N == 1 && rotations);
+	for (uint64_t move = 1; can_move && (options.max_moves == 0 || move <= options.max_moves); ++move)
+	{
+		// No sequence gets under the lower bound
+		if (search.height() <= bound || std::chrono::high_resolution_clock::now() >= deadline)
+			break;
+
+		MoveKind kind = static_cast<MoveKind>(std::uniform_int_distribution<uint32_t>(0, kinds - 1)(engine));
+		uint32_t from = std::uniform_int_distribution<uint32_t>(0, N - 1)(engine);
+		uint32_t to = std::uniform_int_distribution<uint32_t>(0, N - 1)(engine);
+		if (kind != MoveKind::Flip && from == to)
+			continue;
+
+		uint32_t before = search.height();
+		if (search.try_move(Move{kind, from, to}) && search.height() < before && options.on_improvement)
+			options.on_improvement(search.height(), move);
+	}
+
+	// Result from the current sequence
+	Result result{};
+	result.w = W;
+	result.rotations = rotations;
+	result.sort_strategy = strategy;
+	result.h = search.height();
+
+	uint64_t total_area = 0;
+	result.rectangles.reserve(N);
+	for (uint32_t i = 0; i < N; ++i)
+	{
+		const Item &item = search.sequence()[i];
+		const Shape &input = sorted[item.index];
+		const Shape &placed = search.placed()[i];
+
+		// Placements are rotated relative to the dimensions given to the packer
+		bool rotated = (input.is_rotated() != placed.is_rotated()) != (item.orientation == Orientation::Rotated);
+		result.rectangles.emplace_back(input.id(), placed.rect(), rotated);
+		total_area += input.area();
+	}
+	std::sort(result.rectangles.begin(), result.rectangles.end(), [](const Shape &a, const Shape &b)
+			  { return a.id() < b.id(); });
+
+	result.opt_h = bound;
+	result.loss = (1.0 - double(total_area) / (uint64_t(result.w) * result.h)) * 100.0;
+	auto end_time = std::chrono::high_resolution_clock::now();
+	result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+	return result;
+}
@@ -0,0 +1,46 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Local search over the order
+ *                rectangles are placed in
+ *=============================================**/
+
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+
+#include <functional>
+
+#include "../types.h"
+
+/**============================================
+ *            LocalSearchOptions
+ *=============================================**/
+struct LocalSearchOptions
+{
+	double time_limit = 10.0;		 // Seconds, checked between moves
+	uint64_t max_moves = 0;			 // Stop after this many moves, 0 = only the time limit stops the search
+	uint64_t seed = 0;				 // Seeds the choice of moves
+	uint32_t checkpoint_interval = 0; // Placements between checkpoints, 0 picks one from N
+
+	// Called with the new best height and the move that found it
+	std::function<void(uint32_t best_h, uint64_t move)> on_improvement{};
+};
+
+/**============================================
+ *               local_search
+ * Starts from strategy's order and tries random
+ * moves on the sequence: swap two rectangles,
+ * move one to another place, or (with rotations)
+ * flip the orientation one is placed in between
+ * forced and free. A move is kept if the height
+ * does not grow. The packing state is saved
+ * every checkpoint_interval placements, so a
+ * move first changing position i only replays
+ * the placements from the last checkpoint at or
+ * before i, and stops as soon as it is higher
+ * than the current sequence. The search ends
+ * early if the height reaches the lower bound.
+ *=============================================**/
+Result local_search(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy, const LocalSearchOptions &options);
+
+#endif
@@ -0,0 +1,233 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Lower bounds on the optimal
+ *                strip height
+ *=============================================**/
+
+#include <chrono>
+#include <iterator>
+#include <algorithm>
+
+#include "lower_bound.h"
+#include "thread_pool.h"
+
+constexpr uint32_t MAX_ALPHAS = 256; // Alphas tried by the MMV bounds, picked evenly among the widths
+constexpr uint32_t MAX_DFF_K = 16;
+
+// Sums of products of a weight and a height overflow 64 bits on large instances
+__extension__ typedef unsigned __int128 uint128_t;
+
+// Bound internals, kept out of the other translation units (loader.h has its own Instance)
+namespace
+{
+
+// Rectangles of the same size, counted once. Without rotations, rectangles of the same
+// width, h summing their heights: a sum of 32-bit heights needs 64 bits
+struct SizeClass
+{
+	uint32_t w;
+	uint64_t h;
+	uint64_t count;
+};
+
+struct Instance
+{
+	uint32_t W;
+	bool rotations;
+	std::vector<SizeClass> sizes{};
+	std::vector<uint32_t> alphas{}; // Widths <= W / 2, ascending
+	uint32_t tallest = 0;			// Least height of the tallest rectangle
+};
+
+Instance make_instance(uint32_t W, const std::vector<Shape> &rectangles, bool rotations)
+{
+	Instance instance{W, rotations};
+
+	// Without rotations only the width matters to a bound, rectangles of a width stack into one
+	std::vector<std::pair<uint32_t, uint32_t>> dims;
+	dims.reserve(rectangles.size());
+	for (const Shape &rectangle : rectangles)
+	{
+		if (rotations)
+		{
+			uint32_t short_side = std::min(rectangle.w(), rectangle.h()), long_side = std::max(rectangle.w(), rectangle.h());
+			dims.emplace_back(short_side, long_side);
+			// Lying down unless it is too long for the strip
+			instance.tallest = std::max(instance.tallest, long_side <= W ? short_side : long_side);
+		}
+		else
+		{
+			dims.emplace_back(rectangle.w(), rectangle.h());
+			instance.tallest = std::max(instance.tallest, rectangle.h());
+		}
+	}
+	std::sort(dims.begin(), dims.end());
+	for (const auto &dim : dims)
+	{
+		std::vector<SizeClass> &sizes = instance.sizes;
+		if (!sizes.empty() && sizes.back().w == dim.first && (!rotations || sizes.back().h == dim.second))
+		{
+			if (rotations)
+				sizes.back().count++;
+			else
+				sizes.back().h += dim.second;
+		}
+		else
+		{
+			sizes.push_back(SizeClass{dim.first, dim.second, 1});
+		}
+	}
+
+	std::vector<uint32_t> &alphas = instance.alphas;
+	for (const SizeClass &size : instance.sizes)
+	{
+		if (size.w >= 1 && size.w <= W / 2)
+			alphas.push_back(size.w);
+		if (rotations && size.h >= 1 && size.h <= W / 2)
+			alphas.push_back(static_cast<uint32_t>(size.h));
+	}
+	std::sort(alphas.begin(), alphas.end());
+	alphas.erase(std::unique(alphas.begin(), alphas.end()), alphas.end());
+	if (alphas.size() > MAX_ALPHAS)
+	{
+		std::vector<uint32_t> picked(MAX_ALPHAS);
+		for (uint32_t i = 0; i < MAX_ALPHAS; ++i)
+		{
+			picked[i] = alphas[uint64_t(i) * (alphas.size() - 1) / (MAX_ALPHAS - 1)];
+		}
+		alphas.swap(picked);
+	}
+	return instance;
+}
+
+// ceil(sum over the rectangles of weight(width) * height / scale), each rectangle in the
+// orientation fitting in W that gives the least. Rectangles fitting no way are left out
+template <typename Weight>
+uint32_t weighted_bound(const Instance &instance, uint64_t scale, Weight weight)
+{
+	uint128_t sum = 0;
+	for (const SizeClass &size : instance.sizes)
+	{
+		bool upright = size.w <= instance.W;
+		bool sideways = instance.rotations && size.h <= instance.W;
+		if (!upright && !sideways)
+			continue;
+
+		uint128_t least = upright ? uint128_t(weight(size.w)) * size.h : ~uint128_t(0);
+		if (sideways)
+			least = std::min(least, uint128_t(weight(static_cast<uint32_t>(size.h))) * size.w);
+		sum += least * size.count;
+	}
+	uint128_t bound = (sum + scale - 1) / scale;
+	return bound > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(bound);
+}
+
+uint32_t area_bound(const Instance &instance, uint32_t &evaluated)
+{
+	evaluated = 1;
+	return weighted_bound(instance, instance.W, [](uint32_t w)
+						  { return uint64_t(w); });
+}
+
+uint32_t tallest_bound(const Instance &instance, uint32_t &evaluated)
+{
+	evaluated = 1;
+	return instance.tallest;
+}
+
+// Rows holding a rectangle wider than W - alpha have no room left for any rectangle at least
+// alpha wide, rows holding one wider than W / 2 only have what it leaves. Weighing those
+// W and their width, and the rectangles narrower than alpha 0, bounds W * height
+uint32_t mmv_area_bound(const Instance &instance, uint32_t &evaluated)
+{
+	uint32_t W = instance.W, best = 0;
+	for (uint32_t alpha : instance.alphas)
+	{
+		best = std::max(best, weighted_bound(instance, W, [W, alpha](uint32_t w)
+											 { return uint64_t(w > W - alpha ? W : (w >= alpha ? w : 0)); }));
+	}
+	evaluated = instance.alphas.size();
+	return best;
+}
+
+// Same rows, counting rectangles at least alpha wide: floor(W / alpha) of them fit in a row,
+// floor((W - w) / alpha) beside one w > W / 2 wide
+uint32_t mmv_count_bound(const Instance &instance, uint32_t &evaluated)
+{
+	uint32_t W = instance.W, best = 0;
+	for (uint32_t alpha : instance.alphas)
+	{
+		uint64_t per_row = W / alpha;
+		best = std::max(best, weighted_bound(instance, per_row, [W, alpha, per_row](uint32_t w) -> uint64_t
+											 {
+			if (w > W - alpha)
+				return per_row;
+			if (2 * uint64_t(w) > W)
+				return per_row - (W - w) / alpha;
+			return w >= alpha ? 1 : 0; }));
+	}
+	evaluated = instance.alphas.size();
+	return best;
+}
+
+// u^(k)(x) = x if (k + 1) * x is whole, floor((k + 1) * x) / k otherwise, for x = w / W, scaled by k * W
+uint32_t dff_bound(const Instance &instance, uint32_t &evaluated)
+{
+	uint32_t W = instance.W, best = 0;
+	for (uint64_t k = 1; k <= MAX_DFF_K; ++k)
+	{
+		best = std::max(best, weighted_bound(instance, k * W, [W, k](uint32_t w)
+											 {
+			uint64_t scaled = (k + 1) * w;
+			return scaled % W == 0 ? k * w : scaled / W * W; }));
+	}
+	evaluated = MAX_DFF_K;
+	return best;
+}
+
+} // namespace
+
+HeightBound height_lower_bound(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, ThreadPool *pool)
+{
+	using Family = uint32_t (*)(const Instance &, uint32_t &);
+	static const std::pair<const char *, Family> families[] = {
+		{"Area", area_bound},
+		{"Tallest", tallest_bound},
+		{"MMV area", mmv_area_bound},
+		{"MMV count", mmv_count_bound},
+		{"DFF", dff_bound},
+	};
+
+	auto start = std::chrono::high_resolution_clock::now();
+	HeightBound result{};
+	if (W == 0 || rectangles.empty())
+		return result;
+
+	Instance instance = make_instance(W, rectangles, rotations);
+	result.bounds.resize(std::size(families));
+	for (size_t i = 0; i < result.bounds.size(); ++i)
+	{
+		auto run = [&, i]()
+		{
+			auto family_start = std::chrono::high_resolution_clock::now();
+			BoundStats &stats = result.bounds[i];
+			stats.name = families[i].first;
+			stats.value = families[i].second(instance, stats.evaluated);
+			stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - family_start).count();
+		};
+		if (pool)
+			pool->submit(run);
+		else
+			run();
+	}
+	if (pool)
+		pool->wait();
+
+	for (const BoundStats &stats : result.bounds)
+	{
+		result.value = std::max(result.value, stats.value);
+	}
+	result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return result;
+}
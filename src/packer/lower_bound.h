@@ -0,0 +1,57 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Lower bounds on the optimal
+ *                strip height
+ *=============================================**/
+
+#ifndef LOWER_BOUND_H
+#define LOWER_BOUND_H
+
+#include "../types.h"
+
+class ThreadPool;
+
+// One bound family: its best value and what it cost
+struct BoundStats
+{
+	const char *name = "";
+	uint32_t value = 0;
+	uint32_t evaluated = 0; // Parameter values tried
+	double elapsed_ms = 0.0;
+};
+
+/**============================================
+ *                HeightBound
+ * The best bound over all families, with each
+ * family's value and cost
+ *=============================================**/
+struct HeightBound
+{
+	uint32_t value = 0;
+	std::vector<BoundStats> bounds{};
+	double elapsed_ms = 0.0; // Wall time, families run in parallel
+};
+
+/**============================================
+ *             height_lower_bound
+ * No packing of rectangles in a strip of width
+ * W is lower than the bound. Families:
+ * - Area: total area / W
+ * - Tallest: height of the tallest rectangle
+ * - MMV area / MMV count: Martello-Monaci-Vigo,
+ *   for each alpha <= W / 2 among the widths:
+ *   rectangles wider than W / 2 stack, those
+ *   wider than W - alpha fill their rows, and
+ *   those between alpha and W / 2 fill what is
+ *   left, by area or by how many fit in a row
+ * - DFF: Fekete-Schepers dual feasible functions
+ *   u^(k) applied to the widths, k = 1..16
+ * With rotations, each rectangle counts in the
+ * orientation (fitting in W) that gives the least.
+ * If pool is set the families run as tasks on it,
+ * so don't call it from one of pool's tasks.
+ *=============================================**/
+HeightBound height_lower_bound(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, ThreadPool *pool = nullptr);
+
+#endif
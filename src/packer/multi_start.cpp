@@ -0,0 +1,126 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Randomized multi-start search
+ *                over sort orders (GRASP)
+ *=============================================**/
+
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <algorithm>
+
+#include "multi_start.h"
+#include "packer.h"
+#include "thread_pool.h"
+#include "lower_bound.h"
+
+constexpr uint64_t HEURISTICS = static_cast<uint64_t>(Heuristic::Count);
+constexpr uint32_t WINDOW_LEVELS = 6; // Windows of 2, 4, ..., 64 places
+
+// Scratch buffers of one worker
+struct StartBuffers
+{
+	std::vector<Shape> order{};
+	std::vector<Shape> shuffled{};
+	std::vector<std::pair<double, uint32_t>> keys{};
+};
+
+// Moves each rectangle of order to about its place + U(0, window),
+// so close rectangles often swap and far apart ones never do
+void perturb(StartBuffers &buffers, uint32_t window, std::mt19937_64 &engine)
+{
+	std::uniform_real_distribution<double> shift(0.0, window);
+	std::vector<Shape> &order = buffers.order;
+	std::vector<std::pair<double, uint32_t>> &keys = buffers.keys;
+
+	keys.clear();
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		keys.emplace_back(i + shift(engine), i);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	std::vector<Shape> &shuffled = buffers.shuffled;
+	shuffled.clear();
+	for (const auto &key : keys)
+	{
+		shuffled.push_back(order[key.second]);
+	}
+	order.swap(shuffled);
+}
+
+Result solve_multi_start(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, const MultiStartOptions &options)
+{
+	auto start_time = std::chrono::high_resolution_clock::now();
+	auto deadline = start_time + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(options.time_limit));
+
+	std::atomic<uint64_t> next_start{0};
+	std::atomic<uint32_t> best_height{UINT32_MAX};
+	std::atomic<uint64_t> optimal_start{UINT64_MAX}; // First start that finished at the lower bound
+	std::mutex best_mutex;
+	Result best{};
+	uint64_t best_start = UINT64_MAX;
+
+	// The heuristics' own orders always run, further starts until the limits.
+	// Starts after one at the lower bound could at best tie with it
+	auto may_run = [&](uint64_t k)
+	{
+		if (k > optimal_start.load(std::memory_order_relaxed))
+			return false;
+		if (k < HEURISTICS)
+			return true;
+		if (options.max_starts != 0 && k >= options.max_starts)
+			return false;
+		return std::chrono::high_resolution_clock::now() < deadline;
+	};
+
+	ThreadPool pool(options.threads);
+	uint32_t optimal_height = height_lower_bound(W, rectangles, rotations, &pool).value;
+	for (size_t t = 0; t < pool.size(); ++t)
+	{
+		pool.submit([&]()
+					{
+			Solver solver{};
+			StartBuffers buffers{};
+			for (uint64_t k = next_start++; may_run(k); k = next_start++)
+			{
+				Heuristic strategy = static_cast<Heuristic>(k % HEURISTICS);
+				buffers.order.assign(rectangles.begin(), rectangles.end());
+				sort_by_heuristic(buffers.order, strategy);
+				if (k >= HEURISTICS)
+				{
+					std::seed_seq seq{static_cast<uint32_t>(options.seed), static_cast<uint32_t>(options.seed >> 32),
+									  static_cast<uint32_t>(k), static_cast<uint32_t>(k >> 32)};
+					std::mt19937_64 engine(seq);
+					perturb(buffers, 2u << ((k / HEURISTICS - 1) % WINDOW_LEVELS), engine);
+				}
+
+				SolveCutoff cutoff{};
+				cutoff.height_bound = &best_height;
+				cutoff.lower_bound = optimal_height;
+				Result result = solver.solve_in_order(W, buffers.order, rotations, strategy, false, cutoff);
+				if (!result.complete)
+					continue;
+
+				std::lock_guard<std::mutex> lock(best_mutex);
+				if (best_start == UINT64_MAX || result.h < best.h || (result.h == best.h && k < best_start))
+				{
+					bool improved = best_start == UINT64_MAX || result.h < best.h;
+					best = std::move(result);
+					best_start = k;
+					if (best.h < best_height.load(std::memory_order_relaxed))
+						best_height.store(best.h, std::memory_order_relaxed);
+					if (best.h <= optimal_height)
+						optimal_start.store(k, std::memory_order_relaxed);
+					if (improved && options.on_improvement)
+						options.on_improvement(best.h, k);
+				}
+			} });
+	}
+	pool.wait();
+
+	auto end_time = std::chrono::high_resolution_clock::now();
+	best.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+	return best;
+}
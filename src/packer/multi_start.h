@@ -0,0 +1,49 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Randomized multi-start search
+ *                over sort orders (GRASP)
+ *=============================================**/
+
+#ifndef MULTI_START_H
+#define MULTI_START_H
+
+#include <functional>
+
+#include "../types.h"
+
+/**============================================
+ *             MultiStartOptions
+ *=============================================**/
+struct MultiStartOptions
+{
+	double time_limit = 10.0; // Seconds, checked between starts
+	uint64_t max_starts = 0;  // Stop after this many starts, 0 = only the time limit stops the search
+	uint64_t seed = 0;		  // Start k's randomness derives from seed and k only
+	size_t threads = 0;		  // 0 = one per hardware thread
+
+	// Called with the new best height and the start that found it, from a worker thread, one call at a time
+	std::function<void(uint32_t best_h, uint64_t start)> on_improvement{};
+};
+
+/**============================================
+ *             solve_multi_start
+ * Start k < Heuristic::Count places the
+ * rectangles in heuristic k's order, so the
+ * search never does worse than --all. Later
+ * starts take a heuristic's order and shuffle it
+ * locally: each rectangle moves by a random
+ * amount less than a window of 2 to 64 places,
+ * the window growing with k. Starts stop early
+ * once strictly above the best height found,
+ * and no start after one that reached the lower
+ * bound is begun.
+ * The best result is the lowest, then the one
+ * from the first start, so for a given seed and
+ * set of finished starts it doesn't depend on
+ * the thread count. Its elapsed_ms is the
+ * search's wall time.
+ *=============================================**/
+Result solve_multi_start(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, const MultiStartOptions &options);
+
+#endif
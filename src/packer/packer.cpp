@@ -9,59 +9,58 @@
 #include <iostream>
 #include <algorithm>
 #include <iomanip>
+#include <unordered_map>
 
 #include "packer.h"
+#include "hole_index.h"
+#include "dominance_index.h"
+#include "edge_index.h"
+#include "fit_index.h"
+#include "hole_arrays.h"
+#include "arena.h"
+#include "thread_pool.h"
+#include "lower_bound.h"
 
 #define CHECK_VALID false
 
 constexpr uint32_t INT_INFINITY = 1000000000;
 
-// Get Area
-uint32_t Shape::area() const
-{
-	if (!this->area_.has_value())
-	{
-		this->area_ = w_ * h_;
-	}
-	return *this->area_;
-}
-
 // Rotating a shape = Swapping the dimensions
 void Shape::rotate()
 {
-	std::swap(this->w_, this->h_);
+	this->rect_.rotate();
 	this->is_rotated_ = !this->is_rotated_;
 }
 
-// Compare two SHAPES based on basic properties (x,y,w,h)
-bool Shape::operator==(const Shape &shape) const
+// Compare two RECTS based on basic properties (x,y,w,h)
+bool Rect::operator==(const Rect &rect) const
 {
 	return (
-		this->x_ == shape.x_ &&
-		this->y_ == shape.y_ &&
-		this->w_ == shape.w_ &&
-		this->h_ == shape.h_);
+		this->x_ == rect.x_ &&
+		this->y_ == rect.y_ &&
+		this->w_ == rect.w_ &&
+		this->h_ == rect.h_);
 }
 
-// Check if a shape fits in another using
+// Check if a rect fits in another using
 // a comparison of dimensions (theoretical)
-bool Shape::fits_in(const Shape &shape) const
+bool Rect::fits_in(const Rect &rect) const
 {
 	return (
-		this->w_ <= shape.w_ &&
-		this->h_ <= shape.h_);
+		this->w_ <= rect.w_ &&
+		this->h_ <= rect.h_);
 };
 
-// Check if a shape fits in another using
+// Check if a rect fits in another using
 // a comparison of positions (applied)
-bool Shape::is_in(const Shape &shape) const
+bool Rect::is_in(const Rect &rect) const
 {
 	return (
-		this->x_ >= shape.x_ && // TL corner of 'this' shape is inside 'shape'
-		this->y_ >= shape.y_ && //
+		this->x_ >= rect.x_ && // TL corner of 'this' rect is inside 'rect'
+		this->y_ >= rect.y_ && //
 
-		this->x2() <= shape.x2() && // BR corner of 'this' shape is inside 'shape'
-		this->y2() <= shape.y2()	//
+		this->x2() <= rect.x2() && // BR corner of 'this' rect is inside 'rect'
+		this->y2() <= rect.y2()	   //
 	);
 }
 
@@ -71,19 +70,19 @@ bool overlaps(uint32_t Amin, uint32_t Amax, uint32_t Bmin, uint32_t Bmax)
 	return Amin < Bmax && Amax > Bmin;
 }
 
-// Collision detection between 2 shapes
+// Collision detection between 2 rects
 // (Sharing a common border is not considered an intersect)
-bool Shape::intersects(const Shape &shape) const
+bool Rect::intersects(const Rect &rect) const
 {
 	return (
-		overlaps(this->x_, this->x2(), shape.x_, shape.x2()) && // Two shapes only overlap
-		overlaps(this->y_, this->y2(), shape.y_, shape.y2())	// if they overlap in all dimensions
+		overlaps(this->x_, this->x2(), rect.x_, rect.x2()) && // Two rects only overlap
+		overlaps(this->y_, this->y2(), rect.y_, rect.y2())	  // if they overlap in all dimensions
 	);
 }
 
 bool Shape::is_covered(const std::vector<Shape> &shapes) const
 {
-	return std::any_of(shapes.begin(), shapes.end(), [this](Shape shape)
+	return std::any_of(shapes.begin(), shapes.end(), [this](const Shape &shape)
 					   { return this->is_in(shape); });
 }
 
@@ -109,490 +108,1251 @@ bool descending_height(const Shape &a, const Shape &b)
 		   std::make_tuple(b.h(), b.w(), b.area(), -b.id());
 }
 
-// Creates/Cuts Hole into new Holes based on a Shape
-void cut_hole(const Shape &rectangle, const Shape &hole, std::vector<Shape> &holes, uint32_t &next_hole_id)
-{
-	// Create new holes from a Placement / Overlapping
-	// ⬛ => Hole
-	// ⬜ => Rectangle
-	// So we enumerate all the 16 cases where the rectangle can clip inside the Hole
+/**============================================
+ *                  Hole set
+ * Holes in engine order, by (y, x) with holes
+ * sharing a top-left corner in the order
+ * std::sort leaves them: ties in that order
+ * decide between equivalent placements. Between
+ * updates, a hole that is not flagged
+ * MAYBE_COVERED is not inside any hole placed
+ * before it in the list.
+ * The indexes are only kept while there are
+ * more than SCAN_BELOW holes: shorter lists are
+ * scanned instead (HoleArrays, and binary
+ * searches of the sorted list for the merge
+ * partners), which costs less than keeping the
+ * indexes up to date, and gives the same results.
+ *=============================================**/
+// Holes get indexed once there are more than INDEX_ABOVE, and scanned again once there are
+// fewer than SCAN_BELOW, so a count going back and forth doesn't rebuild the indexes each time
+constexpr size_t INDEX_ABOVE = 512;
+constexpr size_t SCAN_BELOW = 256;
 
-	uint32_t rectangle_x2 = rectangle.x2();
-	uint32_t rectangle_y2 = rectangle.y2();
-	uint32_t hole_x2 = hole.x2();
-	uint32_t hole_y2 = hole.y2();
+// A placement of the rectangle in the hole at pos of the list
+struct Placement
+{
+	size_t pos;	  // Position of the hole in the list
+	bool rotated; // Rectangle is rotated
+};
 
-	std::vector<Shape> new_holes{};
+enum HoleFlag : uint8_t
+{
+	MAYBE_COVERED = 1, // An earlier hole in the list may contain this hole
+	GROWN = 2,		   // Hole was grown by merge_holes during this update
+	SEALED_OFF = 4,	   // Hole was dropped by seal_holes, only set while it runs
+};
 
-	// ⬜⬜⬜
-	// ⬜⬜⬜
-	// ⬜⬜⬜
-	// [CASE 1]: Perfect fit!
-	if (
-		rectangle == hole)
-	{
-	} // Only case where we add 0 Holes
-	//
+// A hole going into (or out of) the indexes
+struct IndexChange
+{
+	uint32_t id;
+	Rect hole;
+	bool inserted; // Else removed
+};
 
-	// ⬜⬜⬜
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// [CASE 2]: Top Bar Horizontal
-	else if (
-		rectangle.x() <= hole.x() && // Rectangle's Left Vertical Edge is left to the hole AND
-		rectangle.y() <= hole.y() && // Rectangle's Top Horizontal Edge is above the hole AND
+// What an update changed in the holes, to undo it
+struct HoleUpdate
+{
+	std::vector<Rect> list{};			   // Holes before it
+	std::vector<uint32_t> ids{};		   // Their ids
+	std::vector<uint32_t> maybe_covered{}; // Ids flagged MAYBE_COVERED before it
+	std::vector<IndexChange> changes{};	   // Index changes it made, in order
+	uint32_t next_id = 0;				   // Next hole id before it
+	bool indexed = false;				   // Whether the indexes were kept before it
+};
 
-		rectangle_x2 >= hole_x2 && // Rectangle's Right Vertical Edge is right to the hole AND
+// A list position sorted by key alone, so std::sort takes the same steps it takes on the holes
+struct SortKey
+{
+	uint64_t key;
+	uint32_t pos;
+};
 
-		rectangle_y2 > hole.y() && // Rectangle's Bottom Horizontal Edge passes through the hole
-		rectangle_y2 < hole_y2	   //
-	)
-	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), rectangle_y2, hole_x2 - hole.x(), hole_y2 - rectangle_y2));
-	}
-	//
+struct HoleSet
+{
+	explicit HoleSet(Arena &arena) : edges(arena), fit(arena) {}
+
+	CowVector<Rect> list{};				   // Holes in engine order, shared with checkpoints
+	CowVector<uint32_t> ids{};			   // Id of the hole at each list position
+	HoleArrays arrays{};				   // The list as arrays, rebuilt after each update
+	HoleIndex index{};					   // Intersection queries
+	DominanceIndex containment{};		   // Containment queries
+	EdgeIndex edges;					   // Merge partner queries
+	FitIndex fit;						   // Perfect fit queries
+	bool indexed = false;				   // Whether the indexes are kept, else they are empty
+	std::vector<uint32_t> position{};	   // Position in list, by hole id
+	std::vector<uint8_t> flags{};		   // HoleFlag bits, by hole id
+	std::vector<uint32_t> maybe_covered{}; // Ids of the holes flagged MAYBE_COVERED
+	uint32_t next_id = 0;				   // Hole ids are unique, they key the indexes
+	HoleUpdate *recording = nullptr;	   // Where the next update records itself, if anywhere
+
+	// Scratch buffers reused across updates, list/ids and next_list/next_ids swap on each update
+	// (a list a checkpoint still holds is left to it and next_list starts over)
+	std::vector<uint32_t> visits{};
+	std::vector<Rect> kept{};
+	std::vector<uint32_t> kept_ids{};
+	std::vector<size_t> kept_end{};
+	std::vector<Rect> next_list{};
+	std::vector<uint32_t> next_ids{};
+	std::vector<SortKey> order{};
+	std::vector<Rect> merge_candidates{};
+	std::vector<uint32_t> merge_candidate_ids{};
+	std::vector<Placement> perfect{};
+};
 
-	// ⬛⬛⬜
-	// ⬛⬛⬜
-	// ⬛⬛⬜
-	// [CASE 3]: Right Bar Vertical
-	else if (
-		rectangle.x() > hole.x() && // Rectangle's Left Vertical Edge passes through the hole AND
-		rectangle.x() < hole_x2 &&	//
+void index_hole(HoleSet &holes, uint32_t id, const Rect &hole)
+{
+	if (!holes.indexed)
+		return;
+	if (holes.recording)
+		holes.recording->changes.push_back(IndexChange{id, hole, true});
+	holes.index.insert(id, hole);
+	holes.containment.insert(id, hole);
+	holes.edges.insert(id, hole);
+	holes.fit.insert(id, hole);
+}
 
-		rectangle.y() <= hole.y() && // Rectangle's Top Horizontal Edge is above the hole AND
+void unindex_hole(HoleSet &holes, uint32_t id, const Rect &hole)
+{
+	if (!holes.indexed)
+		return;
+	if (holes.recording)
+		holes.recording->changes.push_back(IndexChange{id, hole, false});
+	holes.index.remove(id, hole);
+	holes.containment.remove(id);
+	holes.edges.remove(id, hole);
+	holes.fit.remove(id, hole);
+}
 
-		rectangle_x2 >= hole_x2 && // Rectangle's Right Vertical Edge is right to the hole AND
+void drop_indexes(HoleSet &holes)
+{
+	holes.indexed = false;
+	holes.index.clear();
+	holes.containment.clear();
+	holes.edges.clear();
+	holes.fit.clear();
+}
 
-		rectangle_y2 >= hole_y2 // Rectangle's Bottom Horizontal Edge is below the hole
-	)
+void build_indexes(HoleSet &holes)
+{
+	holes.indexed = true;
+	for (size_t i = 0; i < holes.list.size(); ++i)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), rectangle.x() - hole.x(), hole_y2 - hole.y()));
+		index_hole(holes, holes.ids[i], holes.list[i]);
 	}
-	//
-
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// ⬜⬜⬜
-	// [CASE 4]: Bottom Bar Horizontal
-	else if (
-		rectangle.x() <= hole.x() && // Rectangle's Left Vertical Edge is left to the hole AND
-
-		rectangle.y() > hole.y() && // Rectangle's Top Horizontal Edge passes through the hole AND
-		rectangle.y() < hole_y2 &&	//
+}
 
-		rectangle_x2 >= hole_x2 && // Rectangle's Right Vertical Edge is right to the hole AND
+// Builds or drops the indexes once the hole count crosses a threshold
+void update_indexing(HoleSet &holes)
+{
+	if (!holes.indexed && holes.list.size() > INDEX_ABOVE)
+		build_indexes(holes);
+	else if (holes.indexed && holes.list.size() < SCAN_BELOW)
+		drop_indexes(holes);
+}
 
-		rectangle_y2 >= hole_y2 // Rectangle's Bottom Horizontal Edge is below the hole
-	)
+void refresh_positions(HoleSet &holes)
+{
+	for (uint32_t i = 0; i < holes.ids.size(); ++i)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), hole_x2 - hole.x(), rectangle.y() - hole.y()));
+		holes.position[holes.ids[i]] = i;
 	}
-	//
-
-	// ⬜⬛⬛
-	// ⬜⬛⬛
-	// ⬜⬛⬛
-	// [CASE 5]: Left Bar Vertical
-	else if (
-		rectangle.x() <= hole.x() && // Rectangle's Left Vertical Edge is left to the hole AND
-
-		rectangle.y() <= hole.y() && // Rectangle's Top Horizontal Edge is above the hole AND
-
-		rectangle_x2 > hole.x() && // Rectangle's Right Vertical Edge passes through the hole AND
-		rectangle_x2 < hole_x2 &&  //
+}
 
-		rectangle_y2 >= hole_y2 // Rectangle's Bottom Horizontal Edge is below the hole
-	)
+void flag_maybe_covered(HoleSet &holes, uint32_t id)
+{
+	if (!(holes.flags[id] & MAYBE_COVERED))
 	{
-		new_holes.push_back(Shape(next_hole_id++, rectangle_x2, hole.y(), hole_x2 - rectangle_x2, hole_y2 - hole.y()));
+		holes.flags[id] |= MAYBE_COVERED;
+		holes.maybe_covered.push_back(id);
 	}
-	//
-
-	// ⬜⬛⬛
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// [CASE 6]: Top Left Corner
-	else if (
-		rectangle.x() <= hole.x() && // Rectangle's Left Vertical Edge is left to the hole AND
-
-		rectangle.y() <= hole.y() && // Rectangle's Top Horizontal Edge is above the hole AND
-
-		rectangle_x2 > hole.x() && // Rectangle's Right Vertical Edge passes through the hole AND
-		rectangle_x2 < hole_x2 &&  //
+}
 
-		rectangle_y2 > hole.y() && // Rectangle's Bottom Horizontal Edge passes through the hole
-		rectangle_y2 < hole_y2	   //
-	)
+// Replaces the holes flagged MAYBE_COVERED by maybe_covered
+void set_maybe_covered(HoleSet &holes, const std::vector<uint32_t> &maybe_covered)
+{
+	for (uint32_t id : holes.maybe_covered)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), rectangle_y2, hole_x2 - hole.x(), hole_y2 - rectangle_y2));
-		new_holes.push_back(Shape(next_hole_id++, rectangle_x2, hole.y(), hole_x2 - rectangle_x2, hole_y2 - hole.y()));
+		holes.flags[id] &= ~MAYBE_COVERED;
 	}
-	//
-
-	// ⬛⬛⬜
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// [CASE 7]: Top Right Corner
-	else if (
-		rectangle.x() > hole.x() && // Rectangle's Left Vertical Edge Crosses in the hole AND
-		rectangle.x() < hole_x2 &&	//
-
-		rectangle.y() <= hole.y() && // Rectangle's Top Horizontal Edge is above the hole AND
-
-		rectangle_x2 > hole.x() && // Rectangle's Right Vertical Edge is right to the hole AND
-		rectangle_x2 >= hole_x2 && //
-
-		rectangle_y2 > hole.y() && // Rectangle's Bottom Horizontal Edge passes through the Hole
-		rectangle_y2 < hole_y2	   //
-	)
+	holes.maybe_covered.clear();
+	for (uint32_t id : maybe_covered)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), rectangle.x() - hole.x(), hole_y2 - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), rectangle_y2, hole_x2 - hole.x(), hole_y2 - rectangle_y2));
+		flag_maybe_covered(holes, id);
 	}
-	//
-
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// ⬛⬛⬜
-	// [CASE 8]: Bottom Right Corner
-	else if (
-		rectangle.x() < hole_x2 &&	// Rectangle's Left Vertical Edge passes through the hole AND
-		rectangle.x() > hole.x() && //
+}
 
-		rectangle.y() > hole.y() && // Rectangle's Top Horizontal Edge passes through the hole AND
-		rectangle.y() < hole_y2 &&	//
+// Start Hole is the width of the entire canvas + an irrelevant height
+void reset_holes(HoleSet &holes, uint32_t W)
+{
+	holes.list.rewrite().assign(1, Rect(0, 0, W, INT_INFINITY));
+	holes.ids.rewrite().assign(1, 1);
+	drop_indexes(holes);
+	holes.position.assign(2, 0);
+	holes.flags.assign(2, 0);
+	holes.maybe_covered.clear();
+	holes.next_id = 2;
+	holes.arrays.build(holes.list.get());
+}
 
-		rectangle_x2 >= hole_x2 && // Rectangle's Right Vertical Edge is right to the hole AND
+// Puts the holes back as they were after an update: same list, ids and flags.
+// The list is shared, not copied, only the indexes are rebuilt, if there are enough holes to need them
+void restore_holes(HoleSet &holes, const std::shared_ptr<const std::vector<Rect>> &list, const std::shared_ptr<const std::vector<uint32_t>> &ids,
+				   const std::vector<uint32_t> &maybe_covered, uint32_t next_id)
+{
+	holes.list.adopt(list);
+	holes.ids.adopt(ids);
+	holes.position.assign(next_id, 0);
+	holes.flags.assign(next_id, 0);
+	holes.maybe_covered.clear();
+	set_maybe_covered(holes, maybe_covered);
+	holes.next_id = next_id;
+	refresh_positions(holes);
+	drop_indexes(holes);
+	update_indexing(holes);
+	holes.arrays.build(holes.list.get());
+}
 
-		rectangle_y2 >= hole_y2 // Rectangle's Bottom Horizontal Edge is below the hole
-	)
-	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), hole_x2 - hole.x(), rectangle.y() - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), rectangle.x() - hole.x(), hole_y2 - hole.y()));
-	}
+// True if a hole contains rect
+bool any_containing(const HoleSet &holes, const Rect &rect)
+{
+	if (holes.indexed)
+		return holes.containment.any_containing(rect);
+	return holes.arrays.for_each_containing(rect, [](size_t)
+											{ return true; });
+}
 
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// ⬜⬛⬛
-	// [CASE 9]: Bottom Left Corner
-	else if (
-		rectangle.x() <= hole.x() && // Rectangle's Left Vertical Edge is left to the hole AND
+/**============================================
+ *               Merge partners
+ * Holes sharing a whole edge with a hole, as
+ * positions in the list, which must be sorted by
+ * (y, x). With the indexes, EdgeIndex finds them,
+ * else binary searches of the list do.
+ *=============================================**/
+bool corner_before(const Rect &a, const Rect &b)
+{
+	return std::make_pair(a.y(), a.x()) < std::make_pair(b.y(), b.x());
+}
 
-		rectangle.y() > hole.y() && // Rectangle's Top Horizontal Edge passes through the hole AND
-		rectangle.y() < hole_y2 &&	//
+// Position of the first hole with its top-left corner at (x, y) or after it
+size_t corner_position(const HoleSet &holes, uint32_t x, uint32_t y)
+{
+	return std::lower_bound(holes.list.begin(), holes.list.end(), Rect(x, y, 0, 0), corner_before) - holes.list.begin();
+}
 
-		rectangle_x2 > hole.x() && // Rectangle's Right Vertical Edge passes through the hole AND
-		rectangle_x2 < hole_x2 &&  //
+// Position of hole (id) in the list, which must hold it
+size_t sorted_position(const HoleSet &holes, uint32_t id, const Rect &hole)
+{
+	size_t pos = corner_position(holes, hole.x(), hole.y());
+	while (holes.ids[pos] != id)
+		++pos;
+	return pos;
+}
 
-		rectangle_y2 >= hole_y2 // Rectangle's Bottom Horizontal Edge passes through the hole
-	)
+// True if the list holds hole with this id
+bool holds_hole(const HoleSet &holes, uint32_t id, const Rect &hole)
+{
+	if (holes.indexed)
+		return holes.edges.contains(id, hole);
+	for (size_t pos = corner_position(holes, hole.x(), hole.y()); pos < holes.list.size() && holes.list[pos].x() == hole.x() && holes.list[pos].y() == hole.y(); ++pos)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), hole_x2 - hole.x(), rectangle.y() - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, rectangle_x2, hole.y(), hole_x2 - rectangle_x2, hole_y2 - hole.y()));
+		if (holes.ids[pos] == id)
+			return holes.list[pos] == hole;
 	}
+	return false;
+}
 
-	// ⬛⬜⬛
-	// ⬛⬜⬛
-	// ⬛⬜⬛
-	// [CASE 10]: Middle Vertical Bar
-	else if (
-		rectangle.x() > hole.x() && // Rectangle's Left Vertical Edge passes through the hole AND
-		rectangle.x() < hole_x2 &&	//
+// Calls f(pos) for each hole whose left edge is the right edge of hole
+template <typename F>
+void for_each_right_of(const HoleSet &holes, const Rect &hole, F &&f)
+{
+	if (holes.indexed)
+	{
+		holes.edges.for_each_right_of(hole, [&holes, &f](uint32_t id, const Rect &other)
+									  { f(sorted_position(holes, id, other)); return false; });
+		return;
+	}
+	for (size_t pos = corner_position(holes, hole.x2(), hole.y()); pos < holes.list.size() && holes.list[pos].x() == hole.x2() && holes.list[pos].y() == hole.y(); ++pos)
+	{
+		if (holes.list[pos].h() == hole.h())
+			f(pos);
+	}
+}
 
-		rectangle.y() <= hole.y() && // Rectangle's Top Horizontal Edge is above the hole AND
+// Calls f(pos) for each hole whose top edge is the bottom edge of hole
+template <typename F>
+void for_each_below(const HoleSet &holes, const Rect &hole, F &&f)
+{
+	if (holes.indexed)
+	{
+		holes.edges.for_each_below(hole, [&holes, &f](uint32_t id, const Rect &other)
+								   { f(sorted_position(holes, id, other)); return false; });
+		return;
+	}
+	for (size_t pos = corner_position(holes, hole.x(), hole.y2()); pos < holes.list.size() && holes.list[pos].x() == hole.x() && holes.list[pos].y() == hole.y2(); ++pos)
+	{
+		if (holes.list[pos].w() == hole.w())
+			f(pos);
+	}
+}
 
-		rectangle_x2 > hole.x() && // Rectangle's Right Vertical Edge passes through the hole AND
-		rectangle_x2 < hole_x2 &&  //
+// Calls f(pos) for each hole whose right edge is the left edge of hole
+template <typename F>
+void for_each_left_of(const HoleSet &holes, const Rect &hole, F &&f)
+{
+	if (holes.indexed)
+	{
+		holes.edges.for_each_left_of(hole, [&holes, &f](uint32_t id, const Rect &other)
+									 { f(sorted_position(holes, id, other)); return false; });
+		return;
+	}
+	for (size_t pos = corner_position(holes, 0, hole.y()); pos < holes.list.size() && holes.list[pos].y() == hole.y(); ++pos)
+	{
+		if (holes.list[pos].x2() == hole.x() && holes.list[pos].h() == hole.h())
+			f(pos);
+	}
+}
 
-		rectangle_y2 >= hole_y2 // Rectangle's Bottom Horizontal Edge is below the hole
-	)
+// Calls f(pos) for each hole whose bottom edge is the top edge of hole
+template <typename F>
+void for_each_above(const HoleSet &holes, const Rect &hole, F &&f)
+{
+	if (holes.indexed)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), rectangle.x() - hole.x(), hole_y2 - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, rectangle_x2, hole.y(), hole_x2 - rectangle_x2, hole_y2 - hole.y()));
+		holes.edges.for_each_above(hole, [&holes, &f](uint32_t id, const Rect &other)
+								   { f(sorted_position(holes, id, other)); return false; });
+		return;
+	}
+	for (size_t pos = 0; pos < holes.list.size() && holes.list[pos].y() < hole.y(); ++pos)
+	{
+		const Rect &other = holes.list[pos];
+		if (other.y2() == hole.y() && other.x() == hole.x() && other.w() == hole.w())
+			f(pos);
 	}
+}
 
-	// ⬛⬛⬛
-	// ⬜⬜⬜
-	// ⬛⬛⬛
-	// [CASE 11]: Middle Horizontal Bar
-	else if (
-		rectangle.x() <= hole.x() && // Rectangle's Left Vertical Edge is left to the hole AND
+// Sorts the list by (y, x). The ids are moved along through a sorted permutation,
+// which std::sort builds with the same comparisons, so holes sharing a top-left
+// corner end up in the order sorting the holes directly gives
+void sort_holes(HoleSet &holes)
+{
+	const std::vector<Rect> &list = holes.list.get();
+	std::vector<SortKey> &order = holes.order;
+	order.resize(list.size());
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = SortKey{(static_cast<uint64_t>(list[i].y()) << 32) | list[i].x(), i};
+	}
+	std::sort(order.begin(), order.end(), [](const SortKey &a, const SortKey &b)
+			  { return a.key < b.key; });
 
-		rectangle.y() > hole.y() && // Rectangle's Top Horizontal Edge passes through the hole AND
-		rectangle.y() < hole_y2 &&	//
+	holes.next_list.clear();
+	holes.next_ids.clear();
+	for (const SortKey &sorted : order)
+	{
+		holes.next_list.push_back(list[sorted.pos]);
+		holes.next_ids.push_back(holes.ids[sorted.pos]);
+	}
+	holes.list.swap_in(holes.next_list);
+	holes.ids.swap_in(holes.next_ids);
+}
 
-		rectangle_x2 >= hole_x2 && // Rectangle's Right Vertical Edge if right to the hole AND
+// Gives the holes ids from 1 in the order of their old ids, which keeps every tie between
+// them as it was, and rebuilds what is keyed by id
+void renumber_holes(HoleSet &holes)
+{
+	std::vector<SortKey> &order = holes.order;
+	order.resize(holes.ids.size());
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = SortKey{holes.ids[i], i};
+	}
+	std::sort(order.begin(), order.end(), [](const SortKey &a, const SortKey &b)
+			  { return a.key < b.key; });
 
-		rectangle_y2 > hole.y() && // Rectangle's Bottom Horizontal Edge is below the hole
-		rectangle_y2 < hole_y2	   //
-	)
+	// Flags follow the holes to their new ids
+	holes.visits.clear();
+	for (uint32_t id : holes.maybe_covered)
+	{
+		holes.visits.push_back(holes.position[id]);
+	}
+	std::vector<uint32_t> &ids = holes.ids.edit();
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		ids[order[i].pos] = i + 1;
+	}
+	holes.next_id = static_cast<uint32_t>(ids.size()) + 1;
+	holes.position.assign(holes.next_id, 0);
+	holes.flags.assign(holes.next_id, 0);
+	holes.maybe_covered.clear();
+	for (uint32_t pos : holes.visits)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), hole_x2 - hole.x(), rectangle.y() - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), rectangle_y2, hole_x2 - hole.x(), hole_y2 - rectangle_y2));
+		flag_maybe_covered(holes, ids[pos]);
 	}
+	refresh_positions(holes);
+	drop_indexes(holes);
+}
 
-	// ⬛⬜⬛
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// [CASE 12]: Top Rectangle Pop-Out
-	else if (
-		rectangle.x() > hole.x() && // Rectangle's Left Vertical Edge passes through the hole AND
-		rectangle.x() < hole_x2 &&	//
+// Cuts the holes at frontier: holes under it go, holes across it keep their part above it.
+// Those are the holes before the first one at or above frontier, the only ones visited. The
+// parts keep their ids, and go first among the holes at frontier sharing their x, in list
+// order. A part inside another hole at frontier (or equal to an earlier one) is dropped:
+// it can only be inside those, and a hole above frontier inside a part was inside the
+// hole cut, so it is flagged already. Ids are renumbered once they outgrow the holes four
+// times over, so the vectors by hole id stay bounded
+void seal_holes(HoleSet &holes, uint32_t frontier)
+{
+	const std::vector<Rect> &list = holes.list.get();
+	const std::vector<uint32_t> &ids = holes.ids.get();
+	size_t below = std::lower_bound(list.begin(), list.end(), frontier, [](const Rect &hole, uint32_t y)
+									{ return hole.y() < y; }) -
+				   list.begin();
+	if (below == 0)
+		return;
+	size_t above = below;
+	while (above < list.size() && list[above].y() == frontier)
+		above++;
+
+	// Parts by x, in list order on ties
+	std::vector<SortKey> &order = holes.order;
+	order.clear();
+	for (uint32_t i = 0; i < below; ++i)
+	{
+		unindex_hole(holes, ids[i], list[i]);
+		if (list[i].y2() > frontier)
+			order.push_back(SortKey{(static_cast<uint64_t>(list[i].x()) << 32) | i, i});
+		else
+			holes.flags[ids[i]] |= SEALED_OFF;
+	}
+	std::sort(order.begin(), order.end(), [](const SortKey &a, const SortKey &b)
+			  { return a.key < b.key; });
+
+	// The row at frontier: parts first on the same x
+	std::vector<Rect> &row = holes.kept;
+	std::vector<uint32_t> &row_ids = holes.kept_ids;
+	std::vector<size_t> &parts = holes.kept_end; // Positions of the parts in row
+	row.clear();
+	row_ids.clear();
+	parts.clear();
+	size_t next = below;
+	for (const SortKey &sorted : order)
+	{
+		const Rect &hole = list[sorted.pos];
+		for (; next < above && list[next].x() < hole.x(); ++next)
+		{
+			row.push_back(list[next]);
+			row_ids.push_back(ids[next]);
+		}
+		parts.push_back(row.size());
+		row.emplace_back(hole.x(), frontier, hole.w(), hole.y2() - frontier);
+		row_ids.push_back(ids[sorted.pos]);
+	}
+	for (; next < above; ++next)
+	{
+		row.push_back(list[next]);
+		row_ids.push_back(ids[next]);
+	}
 
-		rectangle.y() <= hole.y() && // Rectangle's Top Horizontal Edge is above the hole AND
+	// Holes containing a part start at or left of it
+	for (size_t part : parts)
+	{
+		const Rect &hole = row[part];
+		for (size_t other = 0; other < row.size() && row[other].x() <= hole.x(); ++other)
+		{
+			if (other != part && hole.is_in(row[other]) && (!(hole == row[other]) || other < part))
+			{
+				holes.flags[row_ids[part]] |= SEALED_OFF;
+				break;
+			}
+		}
+	}
 
-		rectangle_x2 > hole.x() && // Rectangle's Right Vertical Edge pases through the hole AND
-		rectangle_x2 < hole_x2 &&  //
+	std::vector<Rect> &next_list = holes.next_list;
+	std::vector<uint32_t> &next_ids = holes.next_ids;
+	next_list.clear();
+	next_ids.clear();
+	for (size_t i = 0; i < row.size(); ++i)
+	{
+		if (holes.flags[row_ids[i]] & SEALED_OFF)
+			continue;
+		next_list.push_back(row[i]);
+		next_ids.push_back(row_ids[i]);
+	}
+	for (size_t part : parts)
+	{
+		if (!(holes.flags[row_ids[part]] & SEALED_OFF))
+			index_hole(holes, row_ids[part], row[part]);
+	}
+	next_list.insert(next_list.end(), list.begin() + above, list.end());
+	next_ids.insert(next_ids.end(), ids.begin() + above, ids.end());
 
-		rectangle_y2 > hole.y() && // Rectangle's Bottom Horizontal Edge passes through the hole
-		rectangle_y2 < hole_y2	   //
-	)
+	// Holes sealed off lose their flags
+	size_t flagged = 0;
+	for (uint32_t id : holes.maybe_covered)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), rectangle.x() - hole.x(), hole_y2 - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), rectangle_y2, hole_x2 - hole.x(), hole_y2 - rectangle_y2));
-		new_holes.push_back(Shape(next_hole_id++, rectangle_x2, hole.y(), hole_x2 - rectangle_x2, hole_y2 - hole.y()));
+		if (!(holes.flags[id] & SEALED_OFF))
+			holes.maybe_covered[flagged++] = id;
 	}
+	holes.maybe_covered.resize(flagged);
+	for (uint32_t i = 0; i < below; ++i)
+	{
+		if (holes.flags[ids[i]] & SEALED_OFF)
+			holes.flags[ids[i]] = 0;
+	}
+	holes.list.swap_in(next_list);
+	holes.ids.swap_in(next_ids);
+	refresh_positions(holes);
+
+	if (holes.next_id / 4 > holes.list.size())
+		renumber_holes(holes);
+	update_indexing(holes);
+	holes.arrays.build(holes.list.get());
+}
+
+/**============================================
+ *                  cut_hole
+ * Cutting a hole with a rectangle leaves a piece
+ * on each side where the rectangle's edge passes
+ * through the hole. The 4 edge relations give a
+ * code that picks one of the 16 cases below,
+ * which lists the pieces in the order they get
+ * their ids and enter the hole list.
+ * ⬛ => Hole
+ * ⬜ => Rectangle
+ *=============================================**/
+enum CutSide : uint8_t
+{
+	LEFT,	// Hole left of the rectangle, full height
+	TOP,	// Hole above the rectangle, full width
+	RIGHT,	// Hole right of the rectangle, full height
+	BOTTOM, // Hole below the rectangle, full width
+};
+
+// Bits of the cut code, set when that edge of the rectangle passes through the hole
+enum CutEdge : uint8_t
+{
+	LEFT_EDGE = 1,
+	TOP_EDGE = 2,
+	RIGHT_EDGE = 4,
+	BOTTOM_EDGE = 8,
+};
 
-	// ⬛⬛⬛
-	// ⬛⬛⬜
-	// ⬛⬛⬛
-	// [CASE 13]: Right Rectangle Pop-Out
-	else if (
-		rectangle.x() > hole.x() && // Rectangle's Left Vertical Edge passes through the hole AND
-		rectangle.x() < hole_x2 &&	//
+struct CutCase
+{
+	uint8_t count;
+	CutSide sides[4];
+};
 
-		rectangle.y() > hole.y() && // Rectangle's Top Horizontal Edge passes through the hole AND
-		rectangle.y() < hole_y2 &&	//
+constexpr CutCase CUT_CASES[16] = {
+	{0, {}},						 // [CASE 1]: Perfect fit, or rectangle covers the hole
+	{1, {LEFT}},					 // [CASE 3]: Right Bar Vertical
+	{1, {TOP}},						 // [CASE 4]: Bottom Bar Horizontal
+	{2, {TOP, LEFT}},				 // [CASE 8]: Bottom Right Corner
+	{1, {RIGHT}},					 // [CASE 5]: Left Bar Vertical
+	{2, {LEFT, RIGHT}},				 // [CASE 10]: Middle Vertical Bar
+	{2, {TOP, RIGHT}},				 // [CASE 9]: Bottom Left Corner
+	{3, {LEFT, TOP, RIGHT}},		 // [CASE 14]: Bottom Rectangle Pop-Out
+	{1, {BOTTOM}},					 // [CASE 2]: Top Bar Horizontal
+	{2, {LEFT, BOTTOM}},			 // [CASE 7]: Top Right Corner
+	{2, {TOP, BOTTOM}},				 // [CASE 11]: Middle Horizontal Bar
+	{3, {TOP, LEFT, BOTTOM}},		 // [CASE 13]: Right Rectangle Pop-Out
+	{2, {BOTTOM, RIGHT}},			 // [CASE 6]: Top Left Corner
+	{3, {LEFT, BOTTOM, RIGHT}},		 // [CASE 12]: Top Rectangle Pop-Out
+	{3, {TOP, RIGHT, BOTTOM}},		 // [CASE 15]: Left Rectangle Pop-Out
+	{4, {TOP, LEFT, RIGHT, BOTTOM}}, // [CASE 16]: Rectangle strictly inside the hole (place_at, fill)
+};
 
-		rectangle_x2 >= hole_x2 && // Rectangle's Right Vertical Edge is right to the hole AND
+// Pieces cut_hole leaves of a hole, stored inline
+struct HolePieces
+{
+	Rect list[4]{};
+	uint32_t ids[4]{};
+	uint32_t count = 0;
+};
 
-		rectangle_y2 > hole.y() && // Rectangle's Bottom Horizontal Edge is below the hole
-		rectangle_y2 < hole_y2	   //
-	)
+// Creates/Cuts Hole into new Holes based on a rectangle, which must intersect it
+void cut_hole(const Rect &rectangle, const Rect &hole, HolePieces &pieces, uint32_t &next_hole_id)
+{
+	uint32_t code = (rectangle.x() > hole.x() ? LEFT_EDGE : 0) |
+					(rectangle.y() > hole.y() ? TOP_EDGE : 0) |
+					(rectangle.x2() < hole.x2() ? RIGHT_EDGE : 0) |
+					(rectangle.y2() < hole.y2() ? BOTTOM_EDGE : 0);
+
+	const CutCase &cut = CUT_CASES[code];
+	pieces.count = cut.count;
+	for (uint32_t i = 0; i < cut.count; ++i)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), hole_x2 - hole.x(), rectangle.y() - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), rectangle.x() - hole.x(), hole_y2 - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), rectangle_y2, hole_x2 - hole.x(), hole_y2 - rectangle_y2));
+		pieces.ids[i] = next_hole_id++;
+		switch (cut.sides[i])
+		{
+		case LEFT:
+			pieces.list[i] = Rect(hole.x(), hole.y(), rectangle.x() - hole.x(), hole.h());
+			break;
+		case TOP:
+			pieces.list[i] = Rect(hole.x(), hole.y(), hole.w(), rectangle.y() - hole.y());
+			break;
+		case RIGHT:
+			pieces.list[i] = Rect(rectangle.x2(), hole.y(), hole.x2() - rectangle.x2(), hole.h());
+			break;
+		case BOTTOM:
+			pieces.list[i] = Rect(hole.x(), rectangle.y2(), hole.w(), hole.y2() - rectangle.y2());
+			break;
+		}
 	}
+}
 
-	// ⬛⬛⬛
-	// ⬛⬛⬛
-	// ⬛⬜⬛
-	// [CASE 14]: Bottom Rectangle Pop-Out
-	else if (
-		rectangle.x() > hole.x() && // Rectangle's Left Vertical Edge passes through the hole AND
-		rectangle.x() < hole_x2 &&	//
+// Queues the holes hole now shares a whole edge with on their right or below, as holes that may merge
+void queue_neighbours(HoleSet &holes, const Rect &hole)
+{
+	auto queue = [&holes](size_t pos)
+	{
+		holes.merge_candidates.push_back(holes.list[pos]);
+		holes.merge_candidate_ids.push_back(holes.ids[pos]);
+	};
+	for_each_left_of(holes, hole, queue);
+	for_each_above(holes, hole, queue);
+}
 
-		rectangle.y() > hole.y() && // Rectangle's Top Horizontal Edge passes through the hole AND
-		rectangle.y() < hole_y2 &&	//
+// Queues hole, and the holes it now shares a whole edge with, as holes that may merge
+void queue_merge_candidates(HoleSet &holes, uint32_t id, const Rect &hole)
+{
+	holes.merge_candidates.push_back(hole);
+	holes.merge_candidate_ids.push_back(id);
+	queue_neighbours(holes, hole);
+}
 
-		rectangle_x2 > hole.x() && // Rectangle's Right Vertical Edge passes through the hole AND
-		rectangle_x2 < hole_x2 &&  //
+// Position of the first hole in list order that hole can absorb: to its right, else below it
+std::optional<size_t> get_merge_partner(const HoleSet &holes, const Rect &hole)
+{
+	std::optional<size_t> partner = std::nullopt;
+	auto first = [&partner](size_t pos)
+	{
+		if (!partner || pos < *partner)
+			partner = pos;
+	};
+
+	for_each_right_of(holes, hole, first);
+	if (!partner)
+		for_each_below(holes, hole, first);
+	return partner;
+}
 
-		rectangle_y2 >= hole_y2 // Rectangle's Bottom Horizontal Edge is below the hole
-	)
+// Merge holes next to each other into bigger holes improving QoR.
+// Merges one pair at a time, always the first pair a scan of the list
+// sorted by (y, x) would find. Only pairs with a hole queued as a merge
+// candidate can merge, any other pair was already checked by an earlier
+// update. The pieces the update left are queued, their neighbours are
+// queued once the list is sorted. The list is re-sorted after each merge
+// as std::sort decides the order of holes sharing a top-left corner, and
+// that order decides ties between placements.
+void merge_holes(HoleSet &hole_set)
+{
+	std::vector<Rect> &candidates = hole_set.merge_candidates;
+	std::vector<uint32_t> &candidate_ids = hole_set.merge_candidate_ids;
+	sort_holes(hole_set);
+	for (size_t c = 0, pieces = candidates.size(); c < pieces; ++c)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), rectangle.x() - hole.x(), hole_y2 - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), hole_x2 - hole.x(), rectangle.y() - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, rectangle_x2, hole.y(), hole_x2 - rectangle_x2, hole_y2 - hole.y()));
+		const Rect piece = candidates[c];
+		queue_neighbours(hole_set, piece);
 	}
 
-	// ⬛⬛⬛
-	// ⬜⬛⬛
-	// ⬛⬛⬛
-	// [CASE 15]: Left Rectangle Pop-Out
-	else if (
-		rectangle.x() <= hole.x() && // Rectangle's Left Vertical Edge is left to the hole AND
+	while (true)
+	{
+		// Drop candidates that were merged, grew or have no partner left
+		std::optional<size_t> first = std::nullopt;
+		size_t kept = 0;
+		for (size_t c = 0; c < candidates.size(); ++c)
+		{
+			const Rect candidate = candidates[c];
+			uint32_t candidate_id = candidate_ids[c];
+			if (!holds_hole(hole_set, candidate_id, candidate) || !get_merge_partner(hole_set, candidate))
+				continue;
+			candidates[kept] = candidate;
+			candidate_ids[kept] = candidate_id;
+
+			if (!first || corner_before(candidate, candidates[*first]) ||
+				(candidate.y() == candidates[*first].y() && candidate.x() == candidates[*first].x() &&
+				 sorted_position(hole_set, candidate_id, candidate) < sorted_position(hole_set, candidate_ids[*first], candidates[*first])))
+			{
+				first = kept;
+			}
+			kept++;
+		}
+		candidates.resize(kept);
+		candidate_ids.resize(kept);
+		if (!first)
+			break;
 
-		rectangle.y() > hole.y() && // Rectangle's Top Horizontal Edge passes through the hole AND
-		rectangle.y() < hole_y2 &&	//
+		// The list was just sorted into a buffer of its own, editing it copies nothing
+		std::vector<Rect> &holes = hole_set.list.edit();
+		std::vector<uint32_t> &ids = hole_set.ids.edit();
+		Rect hole = candidates[*first];
+		uint32_t id = candidate_ids[*first];
+		size_t i = sorted_position(hole_set, id, hole);
+		size_t j = *get_merge_partner(hole_set, hole);
+		Rect partner = holes[j];
+
+		unindex_hole(hole_set, id, hole);
+		unindex_hole(hole_set, ids[j], partner);
+		if (partner.y() == hole.y())
+			holes[i] = Rect(hole.x(), hole.y(), hole.w() + partner.w(), hole.h());
+		else
+			holes[i] = Rect(hole.x(), hole.y(), hole.w(), hole.h() + partner.h());
+		index_hole(hole_set, id, holes[i]);
+		hole_set.flags[id] |= GROWN;
+		holes.erase(holes.begin() + j);
+		ids.erase(ids.begin() + j);
+
+		queue_merge_candidates(hole_set, id, holes[i]);
+		sort_holes(hole_set);
+	}
+	candidates.clear();
+	candidate_ids.clear();
+}
 
-		rectangle_x2 > hole.x() && // Rectangle's Bottom Horizontal Edge passes through the hole AND
-		rectangle_x2 < hole_x2 &&  //
+// True if a hole before position key in the list, or kept before it this update
+// (other than hole id itself), contains hole
+bool is_covered_before(const HoleSet &holes, uint32_t id, const Rect &hole, uint32_t key)
+{
+	if (holes.indexed)
+	{
+		return holes.containment.for_each_containing(hole, [&holes, id, key](uint32_t other, const Rect &)
+													 { return other != id && holes.position[other] <= key; });
+	}
+	// Holes cut or dropped so far are erased from the arrays, what replaces them is in kept
+	return holes.arrays.for_each_containing(hole, [key](size_t pos)
+											{ return pos < key; }) ||
+		   std::any_of(holes.kept.begin(), holes.kept.end(), [&hole](const Rect &other)
+					   { return hole.is_in(other); });
+}
 
-		rectangle_y2 > hole.y() && // Rectangle's Right Vertical Edge passes through the hole
-		rectangle_y2 < hole_y2	   //
-	)
+// True if a hole before position pos of the list contains it
+bool is_inside_earlier(const HoleSet &holes, size_t pos)
+{
+	const Rect &hole = holes.list[pos];
+	uint32_t id = holes.ids[pos];
+	if (holes.indexed)
 	{
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), hole.y(), hole_x2 - hole.x(), rectangle.y() - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, rectangle_x2, hole.y(), hole_x2 - rectangle_x2, hole_y2 - hole.y()));
-		new_holes.push_back(Shape(next_hole_id++, hole.x(), rectangle_y2, hole_x2 - hole.x(), hole_y2 - rectangle_y2));
+		return holes.containment.for_each_containing(hole, [&holes, id, pos](uint32_t other, const Rect &)
+													 { return other != id && holes.position[other] < pos; });
 	}
+	// The scan goes in list order, the hole itself comes after any earlier hole containing it
+	bool inside = false;
+	holes.arrays.for_each_containing(hole, [&inside, pos](size_t other)
+									 { inside = other < pos; return true; });
+	return inside;
+}
 
-	// [SPECIAL CASE] Hole is covered by rectangle
-	// do nothing
-	if (hole.is_covered(holes))
+// Calls f(id) for each hole after position pos of the list inside it
+template <typename F>
+void for_each_inside_later(const HoleSet &holes, size_t pos, F &&f)
+{
+	const Rect &hole = holes.list[pos];
+	if (holes.indexed)
 	{
+		holes.containment.for_each_inside(hole, [&holes, &f, pos](uint32_t other, const Rect &)
+										  {
+			if (holes.position[other] > pos)
+				f(other);
+			return false; });
 		return;
 	}
-
-	for (auto new_hole : new_holes)
+	for (size_t other = pos + 1; other < holes.list.size() && holes.list[other].y() < hole.y2(); ++other)
 	{
-		if (!new_hole.is_covered(holes))
-		{
-			holes.push_back(new_hole);
-		}
+		if (holes.list[other].is_in(hole))
+			f(holes.ids[other]);
 	}
 }
 
-// Merge holes next to each other into bigger holes improving QoR
-void merge_holes(std::vector<Shape> &holes)
+// Refreshes positions after merge_holes reordered the list, and flags
+// the holes this update may have put after a hole that contains them
+void refresh_holes(HoleSet &holes, uint32_t first_new_id)
 {
-	bool merged;
-	do
+	const std::vector<Rect> &list = holes.list.get();
+	const std::vector<uint32_t> &ids = holes.ids.get();
+	refresh_positions(holes);
+
+	// New or grown holes may lie inside earlier holes or contain later ones
+	for (uint32_t i = 0; i < list.size(); ++i)
 	{
-		merged = false;
-		std::sort(holes.begin(), holes.end(), [](const Shape &a, const Shape &b)
-				  {
-			if (a.y() != b.y()) return a.y() < b.y();
-			return a.x() < b.x(); });
+		uint32_t id = ids[i];
+		if (id < first_new_id && !(holes.flags[id] & GROWN))
+			continue;
+		holes.flags[id] &= ~GROWN;
 
-		for (size_t i = 0; i < holes.size(); ++i)
+		if (is_inside_earlier(holes, i))
+			flag_maybe_covered(holes, id);
+		for_each_inside_later(holes, i, [&holes](uint32_t other)
+							  { flag_maybe_covered(holes, other); });
+	}
+
+	// Sorting may also swap untouched holes sharing a top-left corner
+	for (size_t run = 0; run < list.size();)
+	{
+		size_t end = run + 1;
+		while (end < list.size() && list[end].x() == list[run].x() && list[end].y() == list[run].y())
+			end++;
+		for (size_t a = run; a < end; ++a)
 		{
-			for (size_t j = i + 1; j < holes.size(); ++j)
+			for (size_t b = a + 1; b < end; ++b)
 			{
-				if (holes[i].y() == holes[j].y() && holes[i].h() == holes[j].h() && holes[i].x2() == holes[j].x())
-				{
-					holes[i] = Shape(holes[i].id(), holes[i].x(), holes[i].y(), holes[i].w() + holes[j].w(), holes[i].h());
-					holes.erase(holes.begin() + j);
-					merged = true;
-					goto next_merge_pass;
-				}
-				if (holes[i].x() == holes[j].x() && holes[i].w() == holes[j].w() && holes[i].y2() == holes[j].y())
-				{
-					holes[i] = Shape(holes[i].id(), holes[i].x(), holes[i].y(), holes[i].w(), holes[i].h() + holes[j].h());
-					holes.erase(holes.begin() + j);
-					merged = true;
-					goto next_merge_pass;
-				}
+				if (list[b].is_in(list[a]))
+					flag_maybe_covered(holes, ids[b]);
 			}
 		}
-	next_merge_pass:;
-	} while (merged);
+		run = end;
+	}
 }
 
-// Main method that splits holes into new holes and then merges holes
-void update_holes(Shape &rectangle, std::vector<Shape> &holes, uint32_t &next_hole_id)
+// Main method that splits holes into new holes and then merges holes.
+// Only the holes the rectangle cuts, or that may be covered, are visited:
+// any other hole keeps its place in the list. Records the update in
+// holes.recording if set, which only holds for this update
+void update_holes(const Rect &rectangle, HoleSet &holes)
 {
-	std::vector<Shape> new_holes{};
-	for (const Shape &hole : holes)
+	uint32_t first_new_id = holes.next_id;
+	if (holes.recording)
 	{
+		HoleUpdate &update = *holes.recording;
+		update.list.assign(holes.list.begin(), holes.list.end());
+		update.ids.assign(holes.ids.begin(), holes.ids.end());
+		update.maybe_covered.assign(holes.maybe_covered.begin(), holes.maybe_covered.end());
+		update.changes.clear();
+		update.next_id = holes.next_id;
+		update.indexed = holes.indexed;
+	}
+
+	std::vector<uint32_t> &visits = holes.visits;
+	visits.clear();
+	if (holes.indexed)
+	{
+		holes.index.for_each_intersecting(rectangle, [&holes, &visits](uint32_t id, const Rect &)
+										  { visits.push_back(holes.position[id]); return false; });
+	}
+	else
+	{
+		holes.arrays.for_each_intersecting(rectangle, [&visits](size_t pos)
+										   { visits.push_back(static_cast<uint32_t>(pos)); return false; });
+	}
+	for (uint32_t id : holes.maybe_covered)
+	{
+		visits.push_back(holes.position[id]);
+	}
+	std::sort(visits.begin(), visits.end());
+	visits.erase(std::unique(visits.begin(), visits.end()), visits.end());
+
+	// Work out what each visited hole becomes, in list order
+	holes.kept.clear();
+	holes.kept_ids.clear();
+	holes.kept_end.clear();
+	for (uint32_t p : visits)
+	{
+		const Rect hole = holes.list[p];
+		const uint32_t id = holes.ids[p];
+		bool maybe_covered = holes.flags[id] & MAYBE_COVERED;
+
 		// If the Current Rectangle overlaps with a hole, we break the hole into new holes
 		if (rectangle.intersects(hole))
 		{
-			cut_hole(rectangle, hole, new_holes, next_hole_id);
+			HolePieces pieces{};
+			cut_hole(rectangle, hole, pieces, holes.next_id);
+			holes.position.resize(holes.next_id);
+			holes.flags.resize(holes.next_id);
+			unindex_hole(holes, id, hole);
+			holes.arrays.erase(p);
+
+			// [SPECIAL CASE] Hole is covered by an earlier hole
+			// do nothing
+			if (maybe_covered && is_covered_before(holes, id, hole, p))
+			{
+				holes.kept_end.push_back(holes.kept.size());
+				continue;
+			}
+
+			for (uint32_t i = 0; i < pieces.count; ++i)
+			{
+				const Rect &piece = pieces.list[i];
+				uint32_t piece_id = pieces.ids[i];
+				if (!is_covered_before(holes, piece_id, piece, p))
+				{
+					holes.position[piece_id] = p;
+					index_hole(holes, piece_id, piece);
+					holes.merge_candidates.push_back(piece);
+					holes.merge_candidate_ids.push_back(piece_id);
+					holes.kept.push_back(piece);
+					holes.kept_ids.push_back(piece_id);
+				}
+			}
+		}
+		else if (maybe_covered && is_covered_before(holes, id, hole, p))
+		{
+			unindex_hole(holes, id, hole);
+			holes.arrays.erase(p);
 		}
-		else if (!(hole.is_covered(new_holes)))
+		else
 		{
-			new_holes.push_back(hole);
+			holes.kept.push_back(hole);
+			holes.kept_ids.push_back(id);
 		}
+		holes.kept_end.push_back(holes.kept.size());
+	}
+
+	for (uint32_t id : holes.maybe_covered)
+	{
+		holes.flags[id] &= ~MAYBE_COVERED;
+	}
+	holes.maybe_covered.clear();
+
+	// Splice the visited holes' replacements into the list
+	std::vector<Rect> &next_list = holes.next_list;
+	std::vector<uint32_t> &next_ids = holes.next_ids;
+	next_list.clear();
+	next_ids.clear();
+	size_t from = 0, kept_begin = 0;
+	for (size_t v = 0; v < visits.size(); ++v)
+	{
+		next_list.insert(next_list.end(), holes.list.begin() + from, holes.list.begin() + visits[v]);
+		next_list.insert(next_list.end(), holes.kept.begin() + kept_begin, holes.kept.begin() + holes.kept_end[v]);
+		next_ids.insert(next_ids.end(), holes.ids.begin() + from, holes.ids.begin() + visits[v]);
+		next_ids.insert(next_ids.end(), holes.kept_ids.begin() + kept_begin, holes.kept_ids.begin() + holes.kept_end[v]);
+		from = visits[v] + 1;
+		kept_begin = holes.kept_end[v];
 	}
-	holes = std::move(new_holes);
+	next_list.insert(next_list.end(), holes.list.begin() + from, holes.list.end());
+	next_ids.insert(next_ids.end(), holes.ids.begin() + from, holes.ids.end());
+	holes.list.swap_in(next_list);
+	holes.ids.swap_in(next_ids);
+
 	merge_holes(holes);
+	holes.arrays.build(holes.list.get());
+	refresh_holes(holes, first_new_id);
+
+	holes.recording = nullptr;
+	update_indexing(holes);
+}
+
+// Puts the holes back as they were before update, which must be the last update not undone.
+// The same holes come back with the same ids and flags. update gives its buffers to the holes
+void undo_update(HoleSet &holes, HoleUpdate &update)
+{
+	holes.list.swap_in(update.list);
+	holes.ids.swap_in(update.ids);
+	if (update.indexed && holes.indexed)
+	{
+		for (auto it = update.changes.rbegin(); it != update.changes.rend(); ++it)
+		{
+			if (it->inserted)
+				unindex_hole(holes, it->id, it->hole);
+			else
+				index_hole(holes, it->id, it->hole);
+		}
+	}
+	else
+	{
+		// The update built or dropped the indexes, they go back to how they were
+		drop_indexes(holes);
+		if (update.indexed)
+			build_indexes(holes);
+	}
+	set_maybe_covered(holes, update.maybe_covered);
+	holes.next_id = update.next_id;
+	refresh_positions(holes);
+	holes.arrays.build(holes.list.get());
 }
 
 // gets y2 of rectangle if we were to place it in hole
-uint32_t get_new_height(const Shape &hole, const Shape &rectangle)
+uint32_t get_new_height(const Rect &hole, const Rect &rectangle)
 {
 	return hole.y() + rectangle.h();
 }
 
-// Differentiation function for get_best_hole, it says if this new hole is better than the current best hole
-bool is_better_hole(const Shape &rectangle, const Shape &hole, const std::optional<Shape> &best_hole, const uint32_t best_height)
+/**============================================
+ *              Best hole search
+ * Placements rank by the tuple
+ * (new height, y, x, hole h, hole w, hole id),
+ * lowest first, and perfect fits win over other
+ * placements. With rotations, a placement only
+ * loses to a perfect fit in its own orientation:
+ * perfect fits in the other orientation are
+ * compared by rank. So a new perfect fit always
+ * replaces a best placement that is not a perfect
+ * fit in its orientation, and the holes are
+ * visited in list order (each as is, then rotated).
+ * Perfect fits come from a size lookup, other
+ * placements from first_fitting over the runs of
+ * the list between perfect fits: the list is
+ * sorted by (y, x), so within a run and an
+ * orientation the first fitting hole, or one
+ * sharing its top-left corner, ranks lowest.
+ * Without the indexes, scan_best_hole visits
+ * every hole that way instead.
+ *=============================================**/
+struct BestHoleSearch
 {
-	if (!rectangle.fits_in(hole))
-		return false;
-	if (!best_hole)
-		return true;
-
-	uint32_t height = get_new_height(hole, rectangle);
-
-	bool hole_is_perfect = (rectangle.w() == hole.w() && rectangle.h() == hole.h());
-	bool best_hole_is_perfect = (rectangle.w() == best_hole->w() && rectangle.h() == best_hole->h());
+	const HoleSet &holes;
+	uint32_t w[2], h[2]; // Rectangle dimensions, as is and rotated
+	bool rotations;
 
-	if (best_hole_is_perfect && !hole_is_perfect)
-		return false;
-	if (hole_is_perfect && !best_hole_is_perfect)
-		return true;
+	std::optional<Placement> best = std::nullopt;
+	bool best_is_perfect = false;
 
-	return std::make_tuple(height, hole.y(), hole.x(), hole.h(), hole.w(), hole.id()) <
-		   std::make_tuple(best_height, best_hole->y(), best_hole->x(), best_hole->h(), best_hole->w(), best_hole->id());
-}
+	auto rank(const Placement &p) const
+	{
+		const Rect &hole = holes.list[p.pos];
+		return std::make_tuple(hole.y() + h[p.rotated], hole.y(), hole.x(), hole.h(), hole.w(), holes.ids[p.pos]);
+	}
 
-// Find the best hole to place our rectangle in
-std::optional<Shape> get_best_hole(Shape &rectangle, const std::vector<Shape> &holes, bool rotations)
-{
-	std::optional<Shape> best_hole = std::nullopt;
-	uint32_t best_height = INT_INFINITY;
-	bool do_rotation = false;
+	bool fits(const Placement &p) const
+	{
+		const Rect &hole = holes.list[p.pos];
+		return w[p.rotated] <= hole.w() && h[p.rotated] <= hole.h();
+	}
 
-	for (const Shape &hole : holes)
+	void consider(const Placement &p)
 	{
-		// Normal Rotation
-		if (is_better_hole(rectangle, hole, best_hole, best_height))
+		if (!best || rank(p) < rank(*best))
 		{
-			best_height = get_new_height(hole, rectangle);
-			best_hole = hole;
-			do_rotation = false;
+			best = p;
+			best_is_perfect = false;
 		}
+	}
 
-		// Rotated Solution
-		if (!rotations)
-			continue;
+	// Lowest ranked placement in [from, to) in one orientation
+	std::optional<Placement> lowest_in_run(size_t from, size_t to, bool rotated) const
+	{
+		size_t first = holes.arrays.first_fitting(from, w[rotated], h[rotated]);
+		if (first >= to)
+			return std::nullopt;
 
-		rectangle.rotate();
-		if (is_better_hole(rectangle, hole, best_hole, best_height))
+		Placement lowest{first, rotated};
+		const Rect &corner = holes.list[first];
+		for (size_t pos = first + 1; pos < to && holes.list[pos].x() == corner.x() && holes.list[pos].y() == corner.y(); ++pos)
 		{
-			best_height = get_new_height(hole, rectangle);
-			best_hole = hole;
-			do_rotation = true;
+			Placement p{pos, rotated};
+			if (fits(p) && rank(p) < rank(lowest))
+				lowest = p;
 		}
-		rectangle.rotate(); // rotate back to original
+		return lowest;
 	}
 
-	if (do_rotation)
-		rectangle.rotate();
-
-	return best_hole;
-}
-
-bool has_sufficient_left_support(const Shape &rectangle, const std::vector<Shape> &placed_rectangles)
-{
-	constexpr float MIN_SUPPORT_RATIO = 0.5f;
-
-	if (rectangle.x() == 0)
+	// Visits the holes in [from, to), none of which is a perfect fit
+	void visit_run(size_t from, size_t to)
 	{
-		return true;
-	}
+		if (from >= to)
+			return;
 
-	uint32_t total_supported_length = 0;
+		if (!best_is_perfect)
+		{
+			if (auto p = lowest_in_run(from, to, false))
+				consider(*p);
+			if (!rotations)
+				return;
+			if (auto p = lowest_in_run(from, to, true))
+				consider(*p);
+			return;
+		}
+
+		// Only the other orientation can beat a perfect fit, find where it first does
+		if (!rotations)
+			return;
+		bool other = !best->rotated;
+		auto best_rank = rank(*best);
+		for (size_t pos = holes.arrays.first_fitting(from, w[other], h[other]); pos < to; pos = holes.arrays.first_fitting(pos + 1, w[other], h[other]))
+		{
+			Placement p{pos, other};
+			auto p_rank = rank(p);
+			if (p_rank < best_rank)
+			{
+				best = p;
+				best_is_perfect = false;
+				if (!other && fits(Placement{pos, true}))
+					consider(Placement{pos, true});
+				visit_run(pos + 1, to);
+				return;
+			}
+			// Later holes rank at least as high in (new height, y, x)
+			if (std::make_tuple(std::get<0>(p_rank), std::get<1>(p_rank), std::get<2>(p_rank)) >
+				std::make_tuple(std::get<0>(best_rank), std::get<1>(best_rank), std::get<2>(best_rank)))
+				return;
+		}
+	}
 
-	for (const Shape &other : placed_rectangles)
+	void visit_perfect(const Placement &p)
 	{
-		if (rectangle == other)
+		if (!best || !best_is_perfect || best->rotated != p.rotated || rank(p) < rank(*best))
 		{
-			continue;
+			best = p;
+			best_is_perfect = true;
 		}
+	}
+};
 
-		bool is_left_neighbor = other.x2() == rectangle.x();
-		bool y_overlaps = rectangle.y() < other.y2() && rectangle.y2() > other.y();
+// A hole and its id
+struct HoleEntry
+{
+	Rect hole;
+	uint32_t id;
+};
 
-		if (is_left_neighbor && y_overlaps)
+// Best placement over every hole, in list order, each as is then rotated. Returns the hole and
+// whether the rectangle goes in rotated
+std::optional<std::pair<Rect, bool>> scan_best_hole(const Rect &rectangle, const HoleSet &holes, bool rotations)
+{
+	uint32_t w[2] = {rectangle.w(), rectangle.h()}, h[2] = {rectangle.h(), rectangle.w()};
+	auto rank = [&h](const HoleEntry &entry, bool rotated)
+	{ return std::make_tuple(entry.hole.y() + h[rotated], entry.hole.y(), entry.hole.x(), entry.hole.h(), entry.hole.w(), entry.id); };
+
+	std::optional<HoleEntry> best = std::nullopt;
+	bool best_rotated = false;
+	for (size_t pos = 0; pos < holes.list.size(); ++pos)
+	{
+		const Rect &hole = holes.list[pos];
+		HoleEntry entry{hole, holes.ids[pos]};
+		for (bool rotated : {false, true})
 		{
-			if (other.h() >= rectangle.h() && other.y() <= rectangle.y() && other.y2() >= rectangle.y2())
+			if ((rotated && !rotations) || w[rotated] > hole.w() || h[rotated] > hole.h())
+				continue;
+			if (best)
 			{
-				return true;
+				// Perfect fits in this orientation win, else the lowest rank
+				bool perfect = hole.w() == w[rotated] && hole.h() == h[rotated];
+				bool best_perfect = best->hole.w() == w[rotated] && best->hole.h() == h[rotated];
+				if (perfect != best_perfect ? !perfect : rank(entry, rotated) >= rank(*best, best_rotated))
+					continue;
 			}
+			best = entry;
+			best_rotated = rotated;
+		}
+	}
 
-			uint32_t overlap_start = std::max(rectangle.y(), other.y());
-			uint32_t overlap_end = std::min(rectangle.y2(), other.y2());
-			total_supported_length += (overlap_end - overlap_start);
+	if (!best)
+		return std::nullopt;
+	return std::make_pair(best->hole, best_rotated);
+}
 
-			if (total_supported_length > rectangle.h() * MIN_SUPPORT_RATIO)
-			{
-				return true;
-			}
+// Find the best hole to place our rectangle in, rotating it (and flipping rotated) if that is better
+std::optional<Rect> get_best_hole(Rect &rectangle, bool &rotated, HoleSet &holes, bool rotations)
+{
+	// Rotating a square changes nothing
+	rotations = rotations && rectangle.w() != rectangle.h();
+	if (!holes.indexed)
+	{
+		auto best = scan_best_hole(rectangle, holes, rotations);
+		if (!best)
+			return std::nullopt;
+		if (best->second)
+		{
+			rectangle.rotate();
+			rotated = !rotated;
+		}
+		return best->first;
+	}
+
+	BestHoleSearch search{holes, {rectangle.w(), rectangle.h()}, {rectangle.h(), rectangle.w()}, rotations};
+
+	std::vector<Placement> &perfect = holes.perfect;
+	perfect.clear();
+	holes.fit.for_each_sized(rectangle.w(), rectangle.h(), [&holes, &perfect](uint32_t id)
+							 { perfect.push_back(Placement{holes.position[id], false}); });
+	if (search.rotations)
+	{
+		holes.fit.for_each_sized(rectangle.h(), rectangle.w(), [&holes, &perfect](uint32_t id)
+								 { perfect.push_back(Placement{holes.position[id], true}); });
+	}
+	std::sort(perfect.begin(), perfect.end(), [](const Placement &a, const Placement &b)
+			  { return a.pos < b.pos; });
+
+	size_t from = 0;
+	for (const Placement &p : perfect)
+	{
+		search.visit_run(from, p.pos);
+		search.visit_perfect(p);
+		from = p.pos + 1;
+	}
+	search.visit_run(from, holes.list.size());
+
+	if (!search.best)
+		return std::nullopt;
+	if (search.best->rotated)
+	{
+		rectangle.rotate();
+		rotated = !rotated;
+	}
+	return holes.list[search.best->pos];
+}
+
+// Placed rectangles' y-intervals [y, y2), by right edge (x2) then by y.
+// Placed rectangles don't overlap, so the intervals sharing a right edge are disjoint
+using RightEdgeIntervals = std::map<uint32_t, uint32_t, std::less<uint32_t>, ArenaAllocator<std::pair<const uint32_t, uint32_t>>>;
+using RightEdges = std::unordered_map<uint32_t, RightEdgeIntervals, std::hash<uint32_t>, std::equal_to<uint32_t>, ArenaAllocator<std::pair<const uint32_t, RightEdgeIntervals>>>;
+
+void add_right_edge(RightEdges &right_edges, const Rect &rectangle)
+{
+	auto edge = right_edges.find(rectangle.x2());
+	if (edge == right_edges.end())
+	{
+		edge = right_edges.emplace(rectangle.x2(), RightEdgeIntervals(right_edges.get_allocator())).first;
+	}
+	edge->second.emplace(rectangle.y(), rectangle.y2());
+}
+
+void remove_right_edge(RightEdges &right_edges, const Rect &rectangle)
+{
+	auto edge = right_edges.find(rectangle.x2());
+	if (edge == right_edges.end())
+		return;
+	edge->second.erase(rectangle.y());
+	if (edge->second.empty())
+		right_edges.erase(edge);
+}
+
+bool has_sufficient_left_support(const Rect &rectangle, const RightEdges &right_edges)
+{
+	constexpr float MIN_SUPPORT_RATIO = 0.5f;
+
+	if (rectangle.x() == 0)
+	{
+		return true;
+	}
+
+	auto edge = right_edges.find(rectangle.x());
+	if (edge == right_edges.end())
+	{
+		return false;
+	}
+
+	// Left neighbors are the intervals on the rectangle's left edge overlapping [y, y2)
+	const RightEdgeIntervals &intervals = edge->second;
+	auto it = intervals.upper_bound(rectangle.y());
+	if (it != intervals.begin())
+	{
+		--it;
+	}
+
+	uint32_t total_supported_length = 0;
+
+	for (; it != intervals.end() && it->first < rectangle.y2(); ++it)
+	{
+		uint32_t other_y = it->first;
+		uint32_t other_y2 = it->second;
+		if (other_y2 <= rectangle.y())
+		{
+			continue;
+		}
+
+		if (other_y <= rectangle.y() && other_y2 >= rectangle.y2())
+		{
+			return true;
+		}
+
+		uint32_t overlap_start = std::max(rectangle.y(), other_y);
+		uint32_t overlap_end = std::min(rectangle.y2(), other_y2);
+		total_supported_length += (overlap_end - overlap_start);
+
+		if (total_supported_length > rectangle.h() * MIN_SUPPORT_RATIO)
+		{
+			return true;
 		}
 	}
 
@@ -607,24 +1367,101 @@ void print_progress(uint32_t a, uint32_t b)
 	std::cout << "\r" << "  > Progress: " << a << "/" << b << " | " << std::fixed << std::setprecision(2) << percentage << "%";
 }
 
-// Main method to solve a packing instance
-Result solve(uint32_t W, std::vector<Shape> rectangles, bool rotations, Heuristic strategy, bool show_progress)
+/**============================================
+ *                  Packing
+ * Holes and right edges of a strip being packed,
+ * shared by Solver and Packer
+ *=============================================**/
+struct Packing
 {
-	// Initializations
-	Result result{};
-	result.w = W;
-	result.rotations = rotations;
-	result.sort_strategy = strategy;
+	Packing() : right_edges(0, std::hash<uint32_t>{}, std::equal_to<uint32_t>{}, RightEdges::allocator_type(arena)) {}
 
-	std::vector<Shape> holes{};
+	Arena arena{}; // Declared first, outlives the containers using it
+	HoleSet holes{arena};
+	RightEdges right_edges; // Placed rectangles, for left support checks
 
-	// Start Hole is the width of the entire canvas + an irrelevant height
-	holes.push_back(Shape(1, 0, 0, W, INT_INFINITY));
+	void reset(uint32_t W)
+	{
+		reset_holes(holes, W);
+		right_edges.clear();
+	}
 
-	// Time
-	auto start = std::chrono::high_resolution_clock::now();
+	// Places rectangle in its best hole (rotating it and flipping rotated if allowed and better)
+	// and updates the holes. Returns the hole it went in, nullopt if no hole fits it
+	std::optional<Rect> place(Rect &rectangle, bool &rotated, bool rotations)
+	{
+		std::optional<Rect> hole = get_best_hole(rectangle, rotated, holes, rotations);
+		if (!hole)
+		{
+			holes.recording = nullptr;
+			return std::nullopt;
+		}
+
+		// Place rectangle in best hole to top-left
+		rectangle.set_position(hole->x(), hole->y());
+
+		// If no rectangles on its left then move it to the right -> bigger hole on its left
+		if (!has_sufficient_left_support(rectangle, right_edges))
+		{
+			rectangle.set_position(hole->x2() - rectangle.w(), hole->y());
+		}
+
+		// Update the holes
+		update_holes(rectangle, holes);
+		add_right_edge(right_edges, rectangle);
+		return hole;
+	}
+
+	// Marks rectangle, as positioned, as used. False if no hole contains it
+	bool occupy(const Rect &rectangle)
+	{
+		if (!any_containing(holes, rectangle))
+		{
+			holes.recording = nullptr;
+			return false;
+		}
+
+		update_holes(rectangle, holes);
+		add_right_edge(right_edges, rectangle);
+		return true;
+	}
+};
+
+/**============================================
+ *                   Solver
+ *=============================================**/
+struct Solver::State
+{
+	Packing packing{};
+	std::vector<Shape> rectangles{}; // Input in placement order, holds the ids
+	std::vector<Rect> placed{};		 // Geometry of rectangles[i] as placed
+	std::vector<uint8_t> rotated{};	 // Whether rectangles[i] is rotated
+	std::function<void(const Shape &placed)> on_place{};
+};
+
+Solver::Solver() : state_(std::make_unique<State>()) {}
+
+Solver::~Solver() = default;
 
-	// Sort based on heuristic
+void Solver::set_on_place(std::function<void(const Shape &placed)> on_place)
+{
+	state_->on_place = std::move(on_place);
+}
+
+Result solve(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy, bool show_progress,
+			 const SolveCutoff &cutoff)
+{
+	Solver solver{};
+	if (cutoff.lower_bound)
+		return solver.solve(W, rectangles, rotations, strategy, show_progress, cutoff);
+	SolveCutoff bounded = cutoff;
+	bounded.lower_bound = height_lower_bound(W, rectangles, rotations).value;
+	return solver.solve(W, rectangles, rotations, strategy, show_progress, bounded);
+}
+
+// Sort based on heuristic
+void sort_by_heuristic(std::vector<Shape> &rectangles, Heuristic strategy)
+{
 	switch (strategy)
 	{
 	case Heuristic::DescendingArea:
@@ -642,13 +1479,95 @@ Result solve(uint32_t W, std::vector<Shape> rectangles, bool rotations, Heuristi
 	default:
 		break;
 	}
+}
+
+bool heuristic_before(Heuristic strategy, const Shape &a, const Shape &b)
+{
+	switch (strategy)
+	{
+	case Heuristic::DescendingArea:
+		return descending_area(a, b);
+	case Heuristic::DescendingArea2:
+		return descending_area_2(a, b);
+	case Heuristic::DescendingWidth:
+		return descending_width(a, b);
+	case Heuristic::DescendingHeight:
+		return descending_height(a, b);
+	default:
+		return a.id() < b.id();
+	}
+}
+
+// Main method to solve a packing instance
+Result Solver::solve(uint32_t W, const std::vector<Shape> &input, bool rotations, Heuristic strategy, bool show_progress,
+					 const SolveCutoff &cutoff)
+{
+	Result result{};
+	solve(result, W, input, rotations, strategy, show_progress, cutoff);
+	return result;
+}
+
+void Solver::solve(Result &result, uint32_t W, const std::vector<Shape> &input, bool rotations, Heuristic strategy,
+				   bool show_progress, const SolveCutoff &cutoff)
+{
+	std::vector<Shape> &rectangles = state_->rectangles;
+	rectangles.assign(input.begin(), input.end());
+
+	// Time
+	auto start = std::chrono::high_resolution_clock::now();
+
+	sort_by_heuristic(rectangles, strategy);
+	place_all(result, W, rotations, strategy, show_progress, cutoff, start);
+}
 
-	uint32_t total_area = 0;
+Result Solver::solve_in_order(uint32_t W, const std::vector<Shape> &input, bool rotations, Heuristic strategy, bool show_progress,
+							  const SolveCutoff &cutoff)
+{
+	Result result{};
+	solve_in_order(result, W, input, rotations, strategy, show_progress, cutoff);
+	return result;
+}
+
+void Solver::solve_in_order(Result &result, uint32_t W, const std::vector<Shape> &input, bool rotations, Heuristic strategy,
+							bool show_progress, const SolveCutoff &cutoff)
+{
+	state_->rectangles.assign(input.begin(), input.end());
+	place_all(result, W, rotations, strategy, show_progress, cutoff, std::chrono::high_resolution_clock::now());
+}
+
+// Places state_->rectangles in order, into result
+void Solver::place_all(Result &result, uint32_t W, bool rotations, Heuristic strategy, bool show_progress,
+					   const SolveCutoff &cutoff, std::chrono::high_resolution_clock::time_point start)
+{
+	// Initializations, result's rectangles keep their memory
+	std::vector<Shape> memory = std::move(result.rectangles);
+	memory.clear();
+	result = Result{};
+	result.rectangles = std::move(memory);
+	result.w = W;
+	result.rotations = rotations;
+	result.sort_strategy = strategy;
+
+	Packing &packing = state_->packing;
+	packing.reset(W);
+
+	std::vector<Shape> &rectangles = state_->rectangles;
+
+	// Geometry and rotation are worked on apart from the ids
+	std::vector<Rect> &placed = state_->placed;
+	std::vector<uint8_t> &rotated = state_->rotated;
+	placed.clear();
+	rotated.clear();
+	for (const Shape &rectangle : rectangles)
+	{
+		placed.push_back(rectangle.rect());
+		rotated.push_back(rectangle.is_rotated());
+	}
+
+	uint64_t total_area = 0;
 	uint32_t solution_height = 0;
-	uint32_t max_rectangle_height = 0;
 
 	uint32_t n = 0, N = rectangles.size();
-	uint32_t next_hole_id = 0;
 
 	// Verbose
 	if (show_progress)
@@ -656,36 +1575,37 @@ Result solve(uint32_t W, std::vector<Shape> rectangles, bool rotations, Heuristi
 		print_progress(n, N);
 	}
 
-	for (Shape &rectangle : rectangles)
+	for (size_t i = 0; i < placed.size(); ++i)
 	{
-		std::optional<Shape> hole = get_best_hole(rectangle, holes, rotations);
+		Rect &rectangle = placed[i];
+		bool is_rotated = rotated[i];
+		std::optional<Rect> hole = packing.place(rectangle, is_rotated, rotations);
+		rotated[i] = is_rotated;
 
 		if (!hole)
 		{
-			throw std::runtime_error("No hole for rectangle " + std::to_string(rectangle.id()));
-		}
-
-		// Place rectangle in best hole to top-left
-		rectangle.set_position(hole->x(), hole->y());
-
-		// If no rectangles on its left then move it to the right -> bigger hole on its left
-		if (!has_sufficient_left_support(rectangle, rectangles))
-		{
-			rectangle.set_position(hole->x2() - rectangle.w(), hole->y());
+			throw std::runtime_error("No hole for rectangle " + std::to_string(rectangles[i].id()));
 		}
 
 		total_area += rectangle.area();
-		max_rectangle_height = std::max(max_rectangle_height, rotations ? std::min(rectangle.w(), rectangle.h()) : rectangle.h());
+		if (state_->on_place)
+			state_->on_place(Shape(rectangles[i].id(), rectangle, is_rotated));
 
 		// Update new height
 		solution_height = std::max(solution_height, get_new_height(*hole, rectangle));
 
-		// Update the holes
-		update_holes(rectangle, holes, next_hole_id);
-
 		n++;
 		if (show_progress)
 			print_progress(n, N);
+
+		// Heights only grow, once past a bound this run can no longer get under it
+		if (solution_height > cutoff.max_height ||
+			(cutoff.height_bound && solution_height > cutoff.height_bound->load(std::memory_order_relaxed)) ||
+			(cutoff.cancel && cutoff.cancel(n, solution_height)))
+		{
+			result.complete = false;
+			break;
+		}
 	}
 	if (show_progress)
 		std::cout << '\n';
@@ -694,21 +1614,26 @@ Result solve(uint32_t W, std::vector<Shape> rectangles, bool rotations, Heuristi
 
 	// Save result
 	result.h = solution_height;
-	result.opt_h = std::max(std::ceil(float(total_area) / float(W)), float(max_rectangle_height));
-	result.loss = (1.f - float(total_area) / (result.w * result.h)) * 100.f;
+	if (result.complete)
+		result.opt_h = cutoff.lower_bound.value_or(0);
+	result.loss = (1.0 - double(total_area) / (uint64_t(result.w) * result.h)) * 100.0;
 	result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-	result.rectangles = rectangles;
+	result.rectangles.reserve(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		result.rectangles.emplace_back(rectangles[i].id(), placed[i], rotated[i]);
+	}
 
 	std::sort(result.rectangles.begin(), result.rectangles.end(), [](const Shape &a, const Shape &b)
 			  { return a.id() < b.id(); });
 
 #if CHECK_VALID
 	bool passed_check = true;
-	for (size_t i = 0; i < rectangles.size(); ++i)
+	for (size_t i = 0; i < n; ++i)
 	{
-		for (size_t j = i + 1; j < rectangles.size(); ++j)
+		for (size_t j = i + 1; j < n; ++j)
 		{
-			if (rectangles[i].intersects(rectangles[j]))
+			if (placed[i].intersects(placed[j]))
 			{
 				passed_check = false;
 				break;
@@ -720,6 +1645,344 @@ Result solve(uint32_t W, std::vector<Shape> rectangles, bool rotations, Heuristi
 	if (show_progress)
 		std::cout << "Solution is " << (passed_check ? "valid" : "not valid") << '\n';
 #endif
+}
+/**============================================
+ *              Heuristic portfolio
+ * Each heuristic runs as its own task with its
+ * own Solver. Finished heights lower the bounds
+ * that running tasks check after each placement.
+ * A run only stops once its height is strictly
+ * above a finished one, so it could not have
+ * been picked, even on a tie: the picked result
+ * is the one running the heuristics one after
+ * another would pick. A run finishing at the
+ * lower bound also stops the later heuristics at
+ * once, they could at best tie with it.
+ *=============================================**/
+// Lowers bound to height if it is lower
+void lower_bound_to(std::atomic<uint32_t> &bound, uint32_t height)
+{
+	uint32_t current = bound.load(std::memory_order_relaxed);
+	while (height < current && !bound.compare_exchange_weak(current, height, std::memory_order_relaxed))
+	{
+	}
+}
 
-	return result;
-}
\ No newline at end of file
+std::vector<Result> solve_portfolio(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, ThreadPool &pool)
+{
+	std::vector<Result> results(static_cast<size_t>(Heuristic::Count));
+	std::vector<std::atomic<uint32_t>> height_bounds(results.size()); // Height each run stops above
+	for (std::atomic<uint32_t> &bound : height_bounds)
+	{
+		bound.store(UINT32_MAX, std::memory_order_relaxed);
+	}
+	uint32_t optimal_height = height_lower_bound(W, rectangles, rotations, &pool).value;
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		pool.submit([&, i]()
+					{
+			Solver solver{};
+			SolveCutoff cutoff{};
+			cutoff.height_bound = &height_bounds[i];
+			cutoff.lower_bound = optimal_height;
+			results[i] = solver.solve(W, rectangles, rotations, static_cast<Heuristic>(i), false, cutoff);
+			if (!results[i].complete)
+				return;
+			for (size_t j = 0; j < height_bounds.size(); ++j)
+			{
+				lower_bound_to(height_bounds[j], j > i && results[i].h <= optimal_height ? 0 : results[i].h);
+			} });
+	}
+	pool.wait();
+	return results;
+}
+
+const Result &best_result(const std::vector<Result> &results)
+{
+	const Result *best = nullptr;
+	for (const Result &result : results)
+	{
+		if (result.complete && (!best || result.h < best->h))
+			best = &result;
+	}
+	return best ? *best : results.front();
+}
+
+/**============================================
+ *                   Packer
+ *=============================================**/
+// What a placement or fill changed, to undo it
+struct PackerUndo
+{
+	HoleUpdate holes{};
+	Rect rectangle{};
+	bool placed = false; // A placement, else a fill
+	uint64_t total_area = 0;
+	uint32_t h = 0;
+	uint32_t max_rectangle_height = 0;
+};
+
+struct Packer::State
+{
+	uint32_t W = 0;
+	Packing packing{};
+	PrefixVector<Shape> rectangles{}; // Not sealed off yet
+	size_t rectangles_kept = 0;		  // Rectangles kept by the last seal that dropped some
+	std::vector<Shape> kept{};		  // Scratch for the seals that drop rectangles
+	uint32_t placed = 0;
+	uint32_t frontier = 0;
+	uint64_t total_area = 0;
+	uint32_t h = 0;
+	uint32_t max_rectangle_height = 0;
+
+	bool keep_undo = false;
+	std::vector<PackerUndo> undo{}; // The first undo_count are live, the rest keep their buffers
+	size_t undo_count = 0;
+
+	// Has the next update record itself in a free undo entry
+	void start_record()
+	{
+		if (!keep_undo)
+			return;
+		if (undo_count == undo.size())
+			undo.emplace_back();
+		packing.holes.recording = &undo[undo_count].holes;
+	}
+
+	// Saves what the change to rectangle just made undoes to, before it touched the stats
+	void record(const Rect &rectangle, bool is_placement)
+	{
+		if (!keep_undo)
+			return;
+		PackerUndo &entry = undo[undo_count++];
+		entry.rectangle = rectangle;
+		entry.placed = is_placement;
+		entry.total_area = total_area;
+		entry.h = h;
+		entry.max_rectangle_height = max_rectangle_height;
+	}
+};
+
+Packer::Packer(uint32_t W) : state_(std::make_unique<State>())
+{
+	reset(W);
+}
+
+Packer::Packer(const PackerCheckpoint &checkpoint) : state_(std::make_unique<State>())
+{
+	restore(checkpoint);
+}
+
+Packer::~Packer() = default;
+
+void Packer::reset(uint32_t W)
+{
+	State &state = *state_;
+	state.W = W;
+	state.packing.reset(W);
+	state.rectangles.clear();
+	state.rectangles_kept = 0;
+	state.undo_count = 0;
+	state.placed = 0;
+	state.frontier = 0;
+	state.total_area = 0;
+	state.h = 0;
+	state.max_rectangle_height = 0;
+}
+
+Shape Packer::place(uint32_t w, uint32_t h, bool allow_rotate)
+{
+	State &state = *state_;
+	uint32_t id = state.placed + 1;
+
+	Rect rectangle(0, 0, w, h);
+	bool rotated = false;
+	state.start_record();
+	std::optional<Rect> hole = state.packing.place(rectangle, rotated, allow_rotate);
+	if (!hole)
+	{
+		throw std::runtime_error("No hole for rectangle " + std::to_string(id));
+	}
+	state.record(rectangle, true);
+
+	state.total_area += rectangle.area();
+	// The tallest counts in its lower orientation that fits the strip
+	uint32_t least_h = allow_rotate && h <= state.W && (w > state.W || w < h) ? w : h;
+	state.max_rectangle_height = std::max(state.max_rectangle_height, least_h);
+	state.h = std::max(state.h, get_new_height(*hole, rectangle));
+
+	state.placed++;
+	state.rectangles.push_back(Shape(id, rectangle, rotated));
+	return state.rectangles.back();
+}
+
+Shape Packer::place_at(uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool rotated)
+{
+	State &state = *state_;
+	uint32_t id = state.placed + 1;
+
+	Rect rectangle(x, y, w, h);
+	state.start_record();
+	if (!state.packing.occupy(rectangle))
+	{
+		throw std::runtime_error("No hole for rectangle " + std::to_string(id) + " at (" + std::to_string(x) + ", " + std::to_string(y) + ")");
+	}
+	state.record(rectangle, true);
+
+	state.total_area += rectangle.area();
+	state.max_rectangle_height = std::max(state.max_rectangle_height, h);
+	state.h = std::max(state.h, rectangle.y2());
+
+	state.placed++;
+	state.rectangles.push_back(Shape(id, rectangle, rotated));
+	return state.rectangles.back();
+}
+
+void Packer::fill(const Rect &area)
+{
+	State &state = *state_;
+	state.start_record();
+	if (!state.packing.occupy(area))
+	{
+		throw std::runtime_error("Area to fill is not free");
+	}
+	state.record(area, false);
+}
+
+void Packer::keep_undo(bool keep)
+{
+	state_->keep_undo = keep;
+	state_->undo_count = 0;
+}
+
+void Packer::undo()
+{
+	State &state = *state_;
+	if (state.undo_count == 0)
+	{
+		throw std::runtime_error("Nothing to undo");
+	}
+	PackerUndo &entry = state.undo[--state.undo_count];
+	undo_update(state.packing.holes, entry.holes);
+	remove_right_edge(state.packing.right_edges, entry.rectangle);
+	if (entry.placed)
+	{
+		state.rectangles.pop_back();
+		state.placed--;
+	}
+	state.total_area = entry.total_area;
+	state.h = entry.h;
+	state.max_rectangle_height = entry.max_rectangle_height;
+}
+
+PackerCheckpoint Packer::checkpoint() const
+{
+	const State &state = *state_;
+	const HoleSet &holes = state.packing.holes;
+
+	PackerCheckpoint checkpoint{};
+	checkpoint.W = state.W;
+	checkpoint.holes = holes.list.share();
+	checkpoint.hole_ids = holes.ids.share();
+	checkpoint.maybe_covered = holes.maybe_covered;
+	checkpoint.next_hole_id = holes.next_id;
+	checkpoint.rectangles = state.rectangles.share();
+	checkpoint.placed = state.placed;
+	checkpoint.frontier = state.frontier;
+	checkpoint.total_area = state.total_area;
+	checkpoint.h = state.h;
+	checkpoint.max_rectangle_height = state.max_rectangle_height;
+	return checkpoint;
+}
+
+void Packer::restore(const PackerCheckpoint &checkpoint)
+{
+	State &state = *state_;
+	state.W = checkpoint.W;
+	restore_holes(state.packing.holes, checkpoint.holes, checkpoint.hole_ids, checkpoint.maybe_covered, checkpoint.next_hole_id);
+	state.rectangles.adopt(checkpoint.rectangles);
+	state.rectangles_kept = 0;
+	state.undo_count = 0;
+	state.packing.right_edges.clear();
+	for (const Shape &rectangle : state.rectangles)
+	{
+		add_right_edge(state.packing.right_edges, rectangle.rect());
+	}
+	state.placed = checkpoint.placed;
+	state.frontier = checkpoint.frontier;
+	state.total_area = checkpoint.total_area;
+	state.h = checkpoint.h;
+	state.max_rectangle_height = checkpoint.max_rectangle_height;
+}
+
+void Packer::seal(uint32_t frontier)
+{
+	State &state = *state_;
+	frontier = std::min(frontier, state.h);
+	if (frontier <= state.frontier)
+		return;
+	state.frontier = frontier;
+	state.undo_count = 0;
+	seal_holes(state.packing.holes, frontier);
+
+	// Rectangles under the frontier can't be a later rectangle's left neighbor, so they can
+	// stay until they are dropped in one pass, once the rectangles held doubled since the last
+	if (state.rectangles.size() < 2 * state.rectangles_kept)
+		return;
+	std::vector<Shape> &kept = state.kept;
+	kept.clear();
+	for (const Shape &rectangle : state.rectangles)
+	{
+		if (rectangle.y2() > frontier)
+			kept.push_back(rectangle);
+	}
+	state.rectangles.clear();
+	state.packing.right_edges.clear();
+	for (const Shape &rectangle : kept)
+	{
+		state.rectangles.push_back(rectangle);
+		add_right_edge(state.packing.right_edges, rectangle.rect());
+	}
+	state.rectangles_kept = kept.size();
+}
+
+uint32_t Packer::frontier() const
+{
+	return state_->frontier;
+}
+
+uint32_t Packer::width() const
+{
+	return state_->W;
+}
+
+uint32_t Packer::height() const
+{
+	return state_->h;
+}
+
+const PrefixVector<Shape> &Packer::rectangles() const
+{
+	return state_->rectangles;
+}
+
+const std::vector<Rect> &Packer::holes() const
+{
+	return state_->packing.holes.list.get();
+}
+
+PackerStats Packer::stats() const
+{
+	const State &state = *state_;
+
+	PackerStats stats{};
+	stats.placed = state.placed;
+	stats.holes = state.packing.holes.list.size();
+	stats.total_area = state.total_area;
+	stats.h = state.h;
+	stats.simple_bound = std::max<uint64_t>((state.total_area + state.W - 1) / state.W, state.max_rectangle_height);
+	if (state.h != 0)
+		stats.loss = (1.0 - double(state.total_area) / (uint64_t(state.W) * state.h)) * 100.0;
+	return stats;
+}
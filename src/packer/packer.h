@@ -1,8 +1,209 @@
 #ifndef PACKER_H
 #define PACKER_H
 
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <functional>
+
 #include "../types.h"
+#include "shared_vector.h"
+
+class ThreadPool;
+
+/**============================================
+ *                SolveCutoff
+ * When a solve gives up: as soon as its height
+ * passes max_height or *height_bound, which other
+ * threads may lower while it runs, or cancel
+ * returns true. It then returns an incomplete
+ * result holding the rectangles placed so far,
+ * without computing its opt_h (left 0).
+ * A complete result takes lower_bound as its
+ * opt_h, 0 if unset: a Solver never computes
+ * it, callers that report opt_h set it to
+ * height_lower_bound's value once per instance.
+ * The solve() function computes it if unset.
+ *=============================================**/
+struct SolveCutoff
+{
+	uint32_t max_height = UINT32_MAX;
+	const std::atomic<uint32_t> *height_bound = nullptr;
+	std::optional<uint32_t> lower_bound{};
+
+	// Called after each placement with the rectangles placed and the height so far
+	std::function<bool(uint32_t placed, uint32_t height)> cancel{};
+};
+
+/**============================================
+ *                   Solver
+ * Owns the holes, indexes and scratch buffers a
+ * solve works with and keeps them between solves,
+ * so solving many instances (bench, --all) reuses
+ * their memory instead of reallocating it.
+ * Use one Solver per thread.
+ *=============================================**/
+class Solver
+{
+public:
+	Solver();
+	~Solver();
+	Solver(const Solver &) = delete;
+	Solver &operator=(const Solver &) = delete;
+
+	// Stops early, with an incomplete result, once cutoff says so
+	Result solve(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy, bool show_progress,
+				 const SolveCutoff &cutoff = {});
+
+	// Same as solve, but places the rectangles in the order given, strategy only labels the result
+	Result solve_in_order(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy, bool show_progress,
+						  const SolveCutoff &cutoff = {});
+
+	// Same as above, but into result, whose rectangles keep their memory: solving again
+	// with a Result and a Solver that held as many rectangles allocates nothing
+	void solve(Result &result, uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy,
+			   bool show_progress, const SolveCutoff &cutoff = {});
+	void solve_in_order(Result &result, uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy,
+						bool show_progress, const SolveCutoff &cutoff = {});
+
+	// Called with each rectangle as solves place it, in placement order, to stream it out.
+	// Placements are final, a cut-off solve only stops calling it
+	void set_on_place(std::function<void(const Shape &placed)> on_place);
+
+private:
+	struct State;
+	std::unique_ptr<State> state_;
+
+	void place_all(Result &result, uint32_t W, bool rotations, Heuristic strategy, bool show_progress,
+				   const SolveCutoff &cutoff, std::chrono::high_resolution_clock::time_point start);
+};
+
+// Sorts rectangles in the order strategy places them
+void sort_by_heuristic(std::vector<Shape> &rectangles, Heuristic strategy);
+
+// True if strategy places a before b, the order sort_by_heuristic sorts in
+bool heuristic_before(Heuristic strategy, const Shape &a, const Shape &b);
+
+// Solves with a one-off Solver
+Result solve(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, Heuristic strategy, bool show_progress,
+			 const SolveCutoff &cutoff = {});
+
+// Solves with every heuristic at once on pool, results are in Heuristic order.
+// A run stops early (incomplete) once its height passes the best finished height,
+// or once an earlier heuristic finished at the lower bound
+std::vector<Result> solve_portfolio(uint32_t W, const std::vector<Shape> &rectangles, bool rotations, ThreadPool &pool);
+
+// Lowest complete result, the first one in order on ties
+const Result &best_result(const std::vector<Result> &results);
+
+/**============================================
+ *                PackerStats
+ * State of an online packing so far
+ *=============================================**/
+struct PackerStats
+{
+	uint32_t placed = 0;	 // Rectangles placed
+	uint32_t holes = 0;		 // Holes left in the strip
+	uint64_t total_area = 0; // Area of the placed rectangles
+	uint32_t h = 0;			 // Height of the packing
+	uint32_t simple_bound = 0; // No packing of the placed rectangles is lower: max(ceil(total_area / W), tallest)
+	float loss = 0.0;		 // Canvas loss as percentage, 0 while nothing is placed
+};
+
+/**============================================
+ *              PackerCheckpoint
+ * A Packer's state after some placements, which
+ * restore() goes back to. Shares the hole list
+ * and the placed rectangles with the Packer
+ * instead of copying them: the Packer's next
+ * update writes a new hole list, and placements
+ * after a restore to a shorter prefix copy that
+ * prefix once.
+ *=============================================**/
+struct PackerCheckpoint
+{
+	uint32_t W = 0;
+	std::shared_ptr<const std::vector<Rect>> holes{};
+	std::shared_ptr<const std::vector<uint32_t>> hole_ids{};
+	std::vector<uint32_t> maybe_covered{}; // Holes that may be inside an earlier one, usually few
+	uint32_t next_hole_id = 0;
+	PrefixVector<Shape>::Prefix rectangles{};
+	uint32_t placed = 0;
+	uint32_t frontier = 0;
+	uint64_t total_area = 0;
+	uint32_t h = 0;
+	uint32_t max_rectangle_height = 0;
+};
+
+/**============================================
+ *                   Packer
+ * Online packing: places rectangles one at a
+ * time, in the order they arrive, the way solve()
+ * places each rectangle of its sorted input.
+ * A placement is final as soon as place() returns.
+ * Each placement re-sorts and rewrites the hole
+ * list, in time linear in its M holes (times a
+ * log): seal() keeps M, and the memory held,
+ * bounded on a long packing.
+ * Use one Packer per thread, Packers sharing
+ * checkpoints on the same thread.
+ *=============================================**/
+class Packer
+{
+public:
+	explicit Packer(uint32_t W);
+	explicit Packer(const PackerCheckpoint &checkpoint); // Fork: a Packer restored to checkpoint
+	~Packer();
+	Packer(const Packer &) = delete;
+	Packer &operator=(const Packer &) = delete;
+
+	// Places a w by h rectangle (rotated if allow_rotate and that fits better) and returns it
+	// as placed. Ids count placements from 1. Throws if the rectangle fits in no hole
+	Shape place(uint32_t w, uint32_t h, bool allow_rotate);
+
+	// Places a w by h rectangle with its bottom left corner at (x, y), rotated only labels it.
+	// Throws if no hole contains it
+	Shape place_at(uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool rotated);
+
+	// Marks area as used without placing a rectangle there (waste). Throws if no hole contains it
+	void fill(const Rect &area);
+
+	// Empties the strip, keeping the memory for the next packing
+	void reset(uint32_t W);
+
+	// With keep, each placement and fill records what it changed, so undo() can take them
+	// back, newest first. Off by default, as the records grow with the placements. reset,
+	// restore and seal drop the records, so undo goes no further back than them
+	void keep_undo(bool keep);
+
+	// Takes back the newest placement or fill not taken back yet, in time linear in the holes
+	// (the hole list before it comes back whole). Throws if there is none recorded
+	void undo();
+
+	// Seals the strip below frontier (at most the height): no later rectangle goes under it.
+	// Holes under it are dropped, holes across it keep their part above it, and the placed
+	// rectangles under it are forgotten, ids still count them. A long online packing sealed
+	// as it grows only holds the strip above its frontier. A lower frontier changes nothing.
+	// Costs a pass over the holes, plus a pass over the rectangles once they doubled since
+	// the last pass, which drops the ones under the frontier
+	void seal(uint32_t frontier);
+
+	// Saves the state in O(1) plus the few holes flagged as maybe covered. restore goes back to a
+	// checkpoint of any Packer, which can then branch off it without changing the checkpoint.
+	// Restoring rebuilds the hole indexes, in time linear in the holes and placed rectangles (times a log)
+	PackerCheckpoint checkpoint() const;
+	void restore(const PackerCheckpoint &checkpoint);
+
+	uint32_t width() const;
+	uint32_t height() const;
+	uint32_t frontier() const;					   // 0 until sealed
+	const PrefixVector<Shape> &rectangles() const; // Placed rectangles not sealed off yet, by id
+	const std::vector<Rect> &holes() const;		   // Holes, by (y, x)
+	PackerStats stats() const;
 
-Result solve(uint32_t W, std::vector<Shape> rectangles, bool rotations, Heuristic strategy, bool show_progress);
+private:
+	struct State;
+	std::unique_ptr<State> state_;
+};
 
-#endif
\ No newline at end of file
+#endif
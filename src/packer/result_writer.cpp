@@ -0,0 +1,160 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Buffered result CSV writer,
+ *                flushed from its own thread
+ *=============================================**/
+
+#include <cstring>
+#include <charconv>
+#include <stdexcept>
+
+#include "result_writer.h"
+
+ResultWriter::ResultWriter(const std::string &path) : path_(path)
+{
+	if (path == "-")
+		out_ = &std::cout;
+	else
+		ofs_.open(path);
+	if (out_ == &ofs_ && !ofs_.is_open())
+		throw std::runtime_error("Cannot open file '" + path + "' for writing");
+	buffer_.resize(BUFFER_BYTES);
+
+	flusher_ = std::thread([this]()
+						   {
+		while (std::optional<std::vector<char>> buffer = full_.pop())
+		{
+			if (!failed_ && !out_->write(buffer->data(), buffer->size()))
+				failed_ = true;
+			buffer->clear();
+			std::lock_guard<std::mutex> lock(spare_mutex_);
+			spare_.push_back(std::move(*buffer));
+		}
+		if (!failed_ && !out_->flush())
+			failed_ = true; });
+}
+
+ResultWriter::~ResultWriter()
+{
+	try
+	{
+		close();
+	}
+	catch (const std::exception &)
+	{
+	}
+}
+
+void ResultWriter::write(const Result &result)
+{
+	write_summary(result);
+	write_columns();
+	for (const Shape &rectangle : result.rectangles)
+	{
+		write_rectangle(rectangle);
+	}
+}
+
+void ResultWriter::write_summary(const Result &result)
+{
+	reserve_line();
+	append("W=", 2);
+	append(uint64_t(result.w));
+	append(",H=", 3);
+	append(uint64_t(result.h));
+	append(",OPT(I)=", 8);
+	append(uint64_t(result.opt_h));
+	append('\n');
+
+	reserve_line();
+	const std::string &strategy = HeuristicStrings.at(result.sort_strategy);
+	append("SORT=", 5);
+	append(strategy.data(), strategy.size());
+	append(",LOSS=", 6);
+	append(result.loss);
+	append("%,rotations=", 12);
+	append(uint64_t(result.rotations));
+	append('\n');
+}
+
+void ResultWriter::write_columns()
+{
+	reserve_line();
+	append("id,x,y,w,h\n", 11);
+}
+
+void ResultWriter::write_rectangle(const Shape &rectangle)
+{
+	reserve_line();
+	append(uint64_t(rectangle.id()));
+	append(',');
+	append(uint64_t(rectangle.x()));
+	append(',');
+	append(uint64_t(rectangle.y()));
+	append(',');
+	append(uint64_t(rectangle.w()));
+	append(',');
+	append(uint64_t(rectangle.h()));
+	append('\n');
+}
+
+void ResultWriter::close()
+{
+	if (closed_)
+		return;
+	closed_ = true;
+	if (used_ != 0)
+		send();
+	full_.close();
+	flusher_.join();
+	if (out_ == &ofs_)
+		ofs_.close();
+	if (failed_ || out_->fail())
+		throw std::runtime_error("Couldn't write to '" + path_ + "'");
+}
+
+// Room for one more line in the buffer
+void ResultWriter::reserve_line()
+{
+	if (BUFFER_BYTES - used_ < MAX_LINE_BYTES)
+		send();
+}
+
+// Queues the buffer for the flusher and continues in a spare one
+void ResultWriter::send()
+{
+	buffer_.resize(used_);
+	full_.push(std::move(buffer_));
+	{
+		std::lock_guard<std::mutex> lock(spare_mutex_);
+		if (spare_.empty())
+		{
+			buffer_ = std::vector<char>();
+		}
+		else
+		{
+			buffer_ = std::move(spare_.back());
+			spare_.pop_back();
+		}
+	}
+	buffer_.resize(BUFFER_BYTES);
+	used_ = 0;
+}
+
+void ResultWriter::append(const char *text, size_t length)
+{
+	std::memcpy(buffer_.data() + used_, text, length);
+	used_ += length;
+}
+
+void ResultWriter::append(uint64_t value)
+{
+	used_ = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value).ptr - buffer_.data();
+}
+
+// Six significant digits, as streams print floats
+void ResultWriter::append(float value)
+{
+	used_ = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value, std::chars_format::general, 6).ptr - buffer_.data();
+}
@@ -0,0 +1,75 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Buffered result CSV writer,
+ *                flushed from its own thread
+ *=============================================**/
+
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+
+#include "../types.h"
+#include "bounded_queue.h"
+
+/**============================================
+ *               ResultWriter
+ * Formats with to_chars into large buffers and
+ * hands full ones to a thread that writes them,
+ * at most a few buffers ahead of the file.
+ * A result CSV is the summary lines (W, H and
+ * OPT(I), then sort and loss), the columns line
+ * and a line per rectangle. write() puts out a
+ * whole result. A streamed one has the columns,
+ * the rectangles as they are placed, and the
+ * summary lines last, once the height is known.
+ *=============================================**/
+class ResultWriter
+{
+public:
+	explicit ResultWriter(const std::string &path); // "-" writes to stdout. Throws if the file can't be opened
+	~ResultWriter();								// Closes, call close() to see write errors
+	ResultWriter(const ResultWriter &) = delete;
+	ResultWriter &operator=(const ResultWriter &) = delete;
+
+	void write(const Result &result); // Summary, columns, then the rectangles in result order
+
+	void write_summary(const Result &result);
+	void write_columns();
+	void write_rectangle(const Shape &rectangle);
+
+	// Writes what is buffered and waits for the file. Throws if a write failed
+	void close();
+
+private:
+	static constexpr size_t BUFFER_BYTES = 1 << 20;
+	static constexpr size_t MAX_LINE_BYTES = 128; // Longest line a write_ call adds
+	static constexpr size_t QUEUED_BUFFERS = 4;
+
+	std::ofstream ofs_;
+	std::ostream *out_ = &ofs_; // ofs_, or std::cout
+	std::string path_;
+	std::vector<char> buffer_{}; // Being filled
+	size_t used_ = 0;
+	BoundedQueue<std::vector<char>> full_{QUEUED_BUFFERS};
+	std::mutex spare_mutex_{};
+	std::vector<std::vector<char>> spare_{}; // Written buffers, for reuse
+	std::atomic<bool> failed_{false};
+	std::thread flusher_{};
+	bool closed_ = false;
+
+	void reserve_line();
+	void send();
+	void flush_all();
+	void append(const char *text, size_t length);
+	void append(uint64_t value);
+	void append(float value);
+	void append(char c) { buffer_[used_++] = c; }
+};
+
+#endif
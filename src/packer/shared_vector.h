@@ -0,0 +1,148 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Vectors that snapshots share
+ *                instead of copying
+ *=============================================**/
+
+#ifndef SHARED_VECTOR_H
+#define SHARED_VECTOR_H
+
+#include <memory>
+#include <vector>
+
+/**============================================
+ *                 CowVector
+ * A vector snapshots share (copy-on-write):
+ * share() is O(1), and the first write while a
+ * snapshot holds the contents copies them.
+ * Reads go to the current contents.
+ *=============================================**/
+template <typename T>
+class CowVector
+{
+public:
+	CowVector() : data_(std::make_shared<std::vector<T>>()) {}
+
+	size_t size() const { return data_->size(); }
+	bool empty() const { return data_->empty(); }
+	const T &operator[](size_t i) const { return (*data_)[i]; }
+	const T &front() const { return data_->front(); }
+	typename std::vector<T>::const_iterator begin() const { return data_->cbegin(); }
+	typename std::vector<T>::const_iterator end() const { return data_->cend(); }
+	const std::vector<T> &get() const { return *data_; }
+
+	// The contents to modify, copied first if shared
+	std::vector<T> &edit()
+	{
+		if (data_.use_count() > 1)
+			data_ = std::make_shared<std::vector<T>>(*data_);
+		return *data_;
+	}
+
+	// A vector to overwrite whole: the current one if not shared, else a new empty one
+	std::vector<T> &rewrite()
+	{
+		if (data_.use_count() > 1)
+			data_ = std::make_shared<std::vector<T>>();
+		return *data_;
+	}
+
+	// Makes values the contents without copying. values gets the old buffer back to reuse,
+	// or an empty vector if a snapshot still holds it
+	void swap_in(std::vector<T> &values)
+	{
+		if (data_.use_count() > 1)
+		{
+			data_ = std::make_shared<std::vector<T>>(std::move(values));
+			values = std::vector<T>();
+		}
+		else
+		{
+			data_->swap(values);
+		}
+	}
+
+	std::shared_ptr<const std::vector<T>> share() const { return data_; }
+
+	// Takes contents from share(), without copying
+	void adopt(const std::shared_ptr<const std::vector<T>> &shared)
+	{
+		data_ = std::const_pointer_cast<std::vector<T>>(shared);
+	}
+
+private:
+	std::shared_ptr<std::vector<T>> data_;
+};
+
+/**============================================
+ *               PrefixVector
+ * Append-only vector whose prefixes snapshots
+ * share. It is a view of the first count values
+ * of a shared vector. Values are never changed
+ * once written, and a view only appends in place
+ * while it ends where the vector ends: a view
+ * restored to a shorter prefix copies it before
+ * its first append. pop_back shortens the vector
+ * too while no snapshot shares it, else only
+ * the view.
+ * Views sharing a vector must stay on one thread.
+ *=============================================**/
+template <typename T>
+class PrefixVector
+{
+public:
+	// The first count values of values
+	struct Prefix
+	{
+		std::shared_ptr<const std::vector<T>> values{};
+		size_t count = 0;
+	};
+
+	PrefixVector() : data_(std::make_shared<std::vector<T>>()) {}
+
+	size_t size() const { return count_; }
+	bool empty() const { return count_ == 0; }
+	const T &operator[](size_t i) const { return (*data_)[i]; }
+	const T &back() const { return (*data_)[count_ - 1]; }
+	const T *begin() const { return data_->data(); }
+	const T *end() const { return data_->data() + count_; }
+
+	void push_back(const T &value)
+	{
+		if (data_->size() != count_)
+			data_ = std::make_shared<std::vector<T>>(data_->begin(), data_->begin() + count_);
+		data_->push_back(value);
+		count_++;
+	}
+
+	void pop_back()
+	{
+		if (data_.use_count() == 1 && data_->size() == count_)
+			data_->pop_back();
+		count_--;
+	}
+
+	void clear()
+	{
+		if (data_.use_count() > 1)
+			data_ = std::make_shared<std::vector<T>>();
+		else
+			data_->clear();
+		count_ = 0;
+	}
+
+	Prefix share() const { return Prefix{data_, count_}; }
+
+	void adopt(const Prefix &prefix)
+	{
+		data_ = std::const_pointer_cast<std::vector<T>>(prefix.values);
+		count_ = prefix.count;
+	}
+
+private:
+	std::shared_ptr<std::vector<T>> data_;
+	size_t count_ = 0;
+};
+
+#endif
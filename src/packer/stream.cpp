@@ -0,0 +1,77 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Packs an endless feed of
+ *                rectangles in bounded memory
+ *=============================================**/
+
+#include <queue>
+#include <stdexcept>
+#include <algorithm>
+
+#include "stream.h"
+#include "packer.h"
+#include "loader.h"
+
+StreamSummary stream_pack(std::istream &in, const std::string &source, const StreamOptions &options)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	StreamSummary summary{};
+	Packer packer(options.W);
+	uint32_t tallest = 0;
+	uint32_t sealed_at = 0; // Frontier the last seal asked for
+
+	// The window's top is the rectangle strategy places first
+	auto after = [&options](const Shape &a, const Shape &b)
+	{ return heuristic_before(options.strategy, b, a); };
+	std::priority_queue<Shape, std::vector<Shape>, decltype(after)> window(after);
+
+	auto place_first = [&]()
+	{
+		Shape next = window.top();
+		window.pop();
+		Shape placed = packer.place(next.w(), next.h(), options.rotations);
+		summary.placed++;
+		if (options.on_place)
+			options.on_place(Shape(next.id(), placed.rect(), placed.is_rotated()));
+
+		// Sealing again only once the frontier moved by a quarter of the depth keeps its cost
+		// (clipping the holes across the frontier) to a fraction of the placements
+		tallest = std::max(tallest, placed.h());
+		uint32_t depth = options.seal_depth != 0 ? options.seal_depth : 4 * tallest;
+		uint32_t frontier = packer.height() > depth ? packer.height() - depth : 0;
+		if (frontier >= sealed_at + std::max<uint32_t>(1, depth / 4))
+		{
+			packer.seal(frontier);
+			sealed_at = frontier;
+		}
+		summary.peak_holes = std::max(summary.peak_holes, packer.holes().size());
+		summary.peak_rectangles = std::max(summary.peak_rectangles, packer.rectangles().size());
+	};
+
+	read_rectangles(in, source, [&](const Shape &rectangle)
+					{
+		if (rectangle.w() > options.W && (!options.rotations || rectangle.h() > options.W))
+			throw std::runtime_error("Rectangle " + std::to_string(rectangle.id()) + " of " + source + " is wider than the strip");
+		window.push(rectangle);
+		if (window.size() >= std::max<size_t>(1, options.window))
+			place_first(); });
+	while (!window.empty())
+	{
+		place_first();
+	}
+
+	PackerStats stats = packer.stats();
+	Result &result = summary.result;
+	result.w = options.W;
+	result.h = stats.h;
+	result.opt_h = stats.simple_bound;
+	result.sort_strategy = options.strategy;
+	result.loss = stats.loss;
+	result.rotations = options.rotations;
+	summary.frontier = packer.frontier();
+	auto end = std::chrono::high_resolution_clock::now();
+	result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+	return summary;
+}
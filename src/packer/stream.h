@@ -0,0 +1,62 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Packs an endless feed of
+ *                rectangles in bounded memory
+ *=============================================**/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <istream>
+#include <functional>
+
+#include "../types.h"
+
+/**============================================
+ *               StreamOptions
+ *=============================================**/
+struct StreamOptions
+{
+	uint32_t W = 0;
+	bool rotations = false;
+	Heuristic strategy = Heuristic::DescendingHeight; // Order within the window
+	size_t window = 1024;							  // Rectangles held back and sorted before placing, 1 = arrival order
+	uint32_t seal_depth = 0;						  // Frontier distance below the top, 0 = four times the tallest rectangle so far
+
+	// Called with each rectangle as it is placed, with its input id
+	std::function<void(const Shape &placed)> on_place{};
+};
+
+/**============================================
+ *               StreamSummary
+ * result has no rectangles, they went out one by
+ * one, and its opt_h is the bound from the area
+ * and the tallest rectangle.
+ *=============================================**/
+struct StreamSummary
+{
+	Result result{};
+	uint64_t placed = 0;
+	uint32_t frontier = 0;		// Last sealed frontier
+	size_t peak_holes = 0;		// Most holes held at once
+	size_t peak_rectangles = 0; // Most placed rectangles held at once, for left support
+};
+
+/**============================================
+ *                stream_pack
+ * Reads <w> <h> lines from in as they arrive and
+ * holds up to window of them, placing the first
+ * in strategy's order each time one more comes
+ * in, then the rest at the end. Nothing is sorted
+ * across windows. As the packing grows the strip
+ * is sealed below a frontier seal_depth under its
+ * top: no rectangle goes under it from then on,
+ * and the holes and rectangles below it are let
+ * go, so memory doesn't grow with the stream.
+ * Throws on a bad line or a rectangle wider than
+ * the strip, once the rectangles before it went.
+ *=============================================**/
+StreamSummary stream_pack(std::istream &in, const std::string &source, const StreamOptions &options);
+
+#endif
@@ -0,0 +1,95 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Fixed pool of worker threads
+ *                running queued tasks
+ *=============================================**/
+
+#include <algorithm>
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	workers_.reserve(threads);
+	for (size_t i = 0; i < threads; ++i)
+	{
+		workers_.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		all_done_.wait(lock, [this]
+					   { return unfinished_ == 0; });
+		stopping_ = true;
+	}
+	task_ready_.notify_all();
+	for (std::thread &worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.push(std::move(task));
+		unfinished_++;
+	}
+	task_ready_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	all_done_.wait(lock, [this]
+				   { return unfinished_ == 0; });
+	if (error_)
+	{
+		std::exception_ptr error = error_;
+		error_ = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void ThreadPool::work()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			task_ready_.wait(lock, [this]
+							 { return stopping_ || !tasks_.empty(); });
+			if (tasks_.empty())
+				return;
+			task = std::move(tasks_.front());
+			tasks_.pop();
+		}
+
+		std::exception_ptr error = nullptr;
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (error && !error_)
+				error_ = error;
+			if (--unfinished_ == 0)
+				all_done_.notify_all();
+		}
+	}
+}
@@ -0,0 +1,53 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Fixed pool of worker threads
+ *                running queued tasks
+ *=============================================**/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/**============================================
+ *                 ThreadPool
+ * Workers take tasks from a queue in the order
+ * they were submitted. wait() blocks until every
+ * submitted task is done and rethrows the first
+ * exception a task threw. The destructor waits
+ * for queued tasks, then joins the workers.
+ *=============================================**/
+class ThreadPool
+{
+public:
+	// threads = 0 uses one thread per hardware thread
+	explicit ThreadPool(size_t threads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	void submit(std::function<void()> task);
+	void wait();
+	size_t size() const { return workers_.size(); }
+
+private:
+	std::vector<std::thread> workers_{};
+	std::queue<std::function<void()>> tasks_{};
+	std::mutex mutex_{};
+	std::condition_variable task_ready_{};
+	std::condition_variable all_done_{};
+	size_t unfinished_ = 0; // Tasks submitted and not yet done
+	bool stopping_ = false;
+	std::exception_ptr error_{};
+
+	void work();
+};
+
+#endif
@@ -1,181 +1,407 @@
-/**==============================================
- * ?                    ABOUT
- * @author      : Romain BESSON
- * @description : Main exe that solves SPP
- *                from list of rectangles
- *                in format <W> <H> (new line)
- *=============================================**/
-
-#include <iostream>
-#include <fstream>
-
-#include "packer/packer.h"		   // 2D Packing Library
-#include "visualizer/visualizer.h" // 2D Visualizing Library
-#include "cxxopts.hpp"			   // CXXOpts for argument parsing
-
-void print_args(const std::string &input_file, uint32_t W, bool rotations, Heuristic strategy, bool show_progress, const std::string &output_file)
-{
-	std::cout << '\n'
-			  << "Solving with:" << '\n';
-	std::cout << "> Input File:      " << input_file << '\n';
-	std::cout << "> Width:           " << W << '\n';
-	std::cout << "> Rotations:       " << (rotations ? "Yes" : "No") << '\n';
-	std::cout << "> Sort Strategy:   " << HeuristicStrings.at(strategy) << '\n';
-	std::cout << "> Show Progress:   " << (show_progress ? "Yes" : "No") << '\n';
-	std::cout << "> Output File:     " << (output_file.empty() ? "None" : output_file) << '\n';
-}
-
-void print_result(const Result &result)
-{
-	std::cout << '\n'
-			  << "Result:" << '\n';
-	std::cout << "> Time Taken:                   " << result.elapsed_ms << "ms" << '\n';
-	std::cout << "> Solution Height:              " << result.h << '\n';
-	std::cout << "> Theoretical Optimal Height:   " << result.opt_h << '\n';
-	std::cout << "> Ratio SOLUTION/OPTIMAL:       " << static_cast<float>(result.h) / result.opt_h << '\n';
-	std::cout << "> Loss:                         " << result.loss << '%' << '\n';
-}
-
-std::string get_font_path(const std::string &exe_path_str)
-{
-	std::filesystem::path exe_path(exe_path_str);
-	return (exe_path.parent_path() / "anon.ttf").string();
-}
-
-int main(int argc, char *argv[])
-{
-	cxxopts::Options options("packer", "A 2D strip packing problem (SPP) solver.");
-
-	options.add_options()
-		("h,help", "Print usage information")
-		("r,rotate", "Allow rectangles to be rotated", cxxopts::value<bool>()->default_value("false"))
-		("v,verbose", "Show packing progress", cxxopts::value<bool>()->default_value("false"))
-		("s,strategy", "Heuristic for sorting rectangles (0-3) (Desc. Area | Desc. Area 2 | Desc Width | Desc Height)", cxxopts::value<int>()->default_value("3"))
-		("a,all", "Solve using all heuristics and output the best result.", cxxopts::value<bool>()->default_value("false"))
-		("o,output", "Output CSV file name", cxxopts::value<std::string>())
-		("input-file", "Input rectangles file (format: <w> <h> per line)", cxxopts::value<std::string>())
-		("width", "The width of the strip for packing", cxxopts::value<uint32_t>());
-	options.positional_help("<input-file> <width>");
-	options.parse_positional({"input-file", "width"});
-
-	cxxopts::ParseResult result;
-	try
-	{
-		result = options.parse(argc, argv);
-	}
-	catch (const cxxopts::exceptions::exception &e)
-	{
-		std::cerr << "Error parsing options: " << e.what() << std::endl;
-		std::cerr << options.help() << std::endl;
-		return EXIT_FAILURE;
-	}
-	if (result.count("help"))
-	{
-		std::cout << options.help() << std::endl;
-		return EXIT_SUCCESS;
-	}
-	if (result.count("input-file") == 0 || result.count("width") == 0)
-	{
-		std::cerr << "Error: Missing required arguments <rectangles_file> and <width>.\n";
-		std::cout << options.help() << std::endl;
-		return EXIT_FAILURE;
-	}
-
-	// Get Args from parsed results
-	std::string exe_path = argv[0];
-	std::string input_file = result["input-file"].as<std::string>();
-	uint32_t W = result["width"].as<uint32_t>();
-	bool rotations = result["rotate"].as<bool>();
-	bool verbose = result["verbose"].as<bool>();
-	auto strategy = static_cast<Heuristic>(std::clamp(result["strategy"].as<int>(), 0, static_cast<int>(Heuristic::Count)-1));
-	bool all_heuristics = result["all"].as<bool>();
-
-	std::string output_file;
-	if (result.count("output"))
-	{
-		output_file = result["output"].as<std::string>();
-	}
-
-	// Reading input file
-	std::vector<Shape> rectangles{};
-	std::ifstream ifs(input_file);
-	if (!ifs.is_open())
-	{
-		std::cerr << '\n'
-				  << "Error: Couldn't open file " << input_file << ": " << std::strerror(errno) << '\n';
-		return EXIT_FAILURE;
-	}
-	uint32_t id = 0;
-	uint32_t w, h;
-	while (ifs >> w >> h)
-	{
-		rectangles.push_back(Shape(++id, 0, 0, w, h));
-	}
-
-	// Solve
-	Result pack_result;
-	if (all_heuristics)
-	{
-		std::cout << '\n'
-		<< "Solving with all heuristics to find the best result..." << '\n';
-		std::cout << "> Input File:      " << input_file << '\n';
-		std::cout << "> Width:           " << W << '\n';
-		std::cout << "> Rotations:       " << (rotations ? "Yes" : "No") << '\n';
-		std::cout << "> Show Progress:   " << (verbose ? "Yes" : "No") << '\n';
-		std::cout << "> Output File:     " << (output_file.empty() ? "None" : output_file) << "\n\n";
-		
-		Result best_result;
-		best_result.h = UINT32_MAX;
-		
-		for (int i = 0; i < static_cast<int>(Heuristic::Count); ++i)
-		{
-			Heuristic current_strategy = static_cast<Heuristic>(i);
-			std::cout << "Testing Strategy: " << HeuristicStrings.at(current_strategy) << " ...\n";
-			
-			Result current_result = solve(W, rectangles, rotations, current_strategy, verbose);
-			
-			std::cout << "  > Result Height: " << current_result.h << " (Time: " << current_result.elapsed_ms << "ms)\n";
-			
-			if (current_result.h < best_result.h)
-			{
-				best_result = current_result;
-				std::cout << "  > New best result found!\n";
-			}
-		}
-		pack_result = best_result;
-		std::cout << "\nBest result found using strategy: \"" << HeuristicStrings.at(pack_result.sort_strategy) << "\"\n";
-	}
-	else
-	{
-		print_args(input_file, W, rotations, strategy, verbose, output_file);
-		pack_result = solve(W, rectangles, rotations, strategy, verbose);
-	}
-
-	print_result(pack_result);
-
-	// Write to output file
-	if (!output_file.empty())
-	{
-		std::ofstream ofs(output_file);
-		if (!ofs.is_open())
-		{
-			std::cerr << "Error: Cannot open file '" << output_file << "' for writing.\n";
-		}
-		else
-		{
-			ofs << "W=" << pack_result.w << ",H=" << pack_result.h << ",OPT(I)=" << pack_result.opt_h << '\n';
-			ofs << "SORT=" << HeuristicStrings.at(pack_result.sort_strategy) << ",LOSS=" << pack_result.loss << '%' << ",rotations=" << pack_result.rotations << '\n';
-			ofs << "id,x,y,w,h" << '\n';
-
-			for (const Shape &rectangle : pack_result.rectangles)
-			{
-				ofs << rectangle.id() << "," << rectangle.x() << "," << rectangle.y() << "," << rectangle.w() << "," << rectangle.h() << "\n";
-			}
-		}
-	}
-
-	// Visualize result
-	visualize(pack_result, 1280, 720, get_font_path(exe_path));
-
-	return EXIT_SUCCESS;
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Main exe that solves SPP
+ *                from list of rectangles
+ *                in format <W> <H> (new line)
+ *=============================================**/
+
+#include <iostream>
+#include <fstream>
+#include <random>
+
+#include "packer/packer.h"		   // 2D Packing Library
+#include "packer/thread_pool.h"	   // Worker threads for --all
+#include "packer/multi_start.h"	   // Randomized multi-start search
+#include "packer/local_search.h"   // Local search over the placement order
+#include "packer/lower_bound.h"	   // Lower bounds on the optimal height
+#include "packer/exact.h"		   // Exact branch-and-bound solver
+#include "packer/batch.h"		   // Many instances in one run
+#include "packer/loader.h"		   // Memory-mapped instance reading
+#include "packer/result_writer.h"   // Buffered result CSV writing
+#include "packer/stream.h"		   // Bounded-memory packing of a rectangle feed
+#include "visualizer/visualizer.h" // 2D Visualizing Library
+#include "cxxopts.hpp"			   // CXXOpts for argument parsing
+
+void print_args(const std::string &input_file, uint32_t W, bool rotations, Heuristic strategy, bool show_progress, const std::string &output_file)
+{
+	std::cout << '\n'
+			  << "Solving with:" << '\n';
+	std::cout << "> Input File:      " << input_file << '\n';
+	std::cout << "> Width:           " << W << '\n';
+	std::cout << "> Rotations:       " << (rotations ? "Yes" : "No") << '\n';
+	std::cout << "> Sort Strategy:   " << HeuristicStrings.at(strategy) << '\n';
+	std::cout << "> Show Progress:   " << (show_progress ? "Yes" : "No") << '\n';
+	std::cout << "> Output File:     " << (output_file.empty() ? "None" : output_file) << '\n';
+}
+
+void print_result(const Result &result)
+{
+	std::cout << '\n'
+			  << "Result:" << '\n';
+	std::cout << "> Time Taken:                   " << result.elapsed_ms << "ms" << '\n';
+	std::cout << "> Solution Height:              " << result.h << '\n';
+	std::cout << "> Theoretical Optimal Height:   " << result.opt_h << (result.h == result.opt_h ? " (solution is optimal)" : "") << '\n';
+	std::cout << "> Ratio SOLUTION/OPTIMAL:       " << static_cast<float>(result.h) / result.opt_h << '\n';
+	std::cout << "> Loss:                         " << result.loss << '%' << '\n';
+}
+
+void print_bound(const HeightBound &bound)
+{
+	std::cout << '\n'
+			  << "Lower Bounds (" << bound.elapsed_ms << "ms):" << '\n';
+	for (const BoundStats &stats : bound.bounds)
+	{
+		std::cout << "> " << stats.name << ": " << stats.value << " (" << stats.evaluated << " tried, " << stats.elapsed_ms << "ms)" << '\n';
+	}
+}
+
+std::string get_font_path(const std::string &exe_path_str)
+{
+	std::filesystem::path exe_path(exe_path_str);
+	return (exe_path.parent_path() / "anon.ttf").string();
+}
+
+int main(int argc, char *argv[])
+{
+	cxxopts::Options options("packer", "A 2D strip packing problem (SPP) solver.");
+
+	options.add_options()
+		("h,help", "Print usage information")
+		("r,rotate", "Allow rectangles to be rotated", cxxopts::value<bool>()->default_value("false"))
+		("v,verbose", "Show packing progress", cxxopts::value<bool>()->default_value("false"))
+		("s,strategy", "Heuristic for sorting rectangles (0-3) (Desc. Area | Desc. Area 2 | Desc Width | Desc Height)", cxxopts::value<int>()->default_value("3"))
+		("a,all", "Solve using all heuristics and output the best result.", cxxopts::value<bool>()->default_value("false"))
+		("m,multi-start", "Search randomized sort orders on all cores and output the best result.", cxxopts::value<bool>()->default_value("false"))
+		("l,local-search", "Improve the strategy's placement order with swap, insert and flip moves and output the result.", cxxopts::value<bool>()->default_value("false"))
+		("x,exact", "Search for an optimal packing with branch-and-bound on all cores and output the best result (small instances).", cxxopts::value<bool>()->default_value("false"))
+		("time-limit", "Seconds the multi-start, local or exact search runs for", cxxopts::value<double>()->default_value("10"))
+		("node-limit", "Nodes the exact search explores at most (0 for no limit)", cxxopts::value<uint64_t>()->default_value("0"))
+		("seed", "Seed of the multi-start or local search (random if not set)", cxxopts::value<uint64_t>())
+		("b,batch", "Solve every instance in a directory (recursively) or listed in a file, one per line, without the window. Widths come from the instances (see <input-file>), else <width>", cxxopts::value<std::string>())
+		("o,output", "Output CSV file name (with --batch, output directory)", cxxopts::value<std::string>())
+		("stream-output", "Write each rectangle to the output CSV as it is placed, the summary lines come last (single strategy only)", cxxopts::value<bool>()->default_value("false"))
+		("stream", "Pack the rectangles of <input-file>, a pipe or stdin (no file or -) as they arrive, in bounded memory, writing each to the output CSV (stdout if none) as it is placed. Needs <width>, no window", cxxopts::value<bool>()->default_value("false"))
+		("window", "Rectangles --stream holds back and sorts with the strategy before placing one (1 for arrival order)", cxxopts::value<size_t>()->default_value("1024"))
+		("seal-depth", "How far under the top --stream seals the strip, no rectangle goes below the seal (0 for four times the tallest rectangle)", cxxopts::value<uint32_t>()->default_value("0"))
+		("input-file", "Input rectangles file: <w> <h> lines (W and OPTH from _W<width>_OPTH<height> in the name), a <W> line then <h>,<w> lines (ngcut), OR-Lib (<file>:<problem> picks a problem) or binary", cxxopts::value<std::string>())
+		("width", "The width of the strip for packing (optional if the instance gives it)", cxxopts::value<uint32_t>());
+	options.positional_help("<input-file> <width>");
+	options.parse_positional({"input-file", "width"});
+
+	cxxopts::ParseResult result;
+	try
+	{
+		result = options.parse(argc, argv);
+	}
+	catch (const cxxopts::exceptions::exception &e)
+	{
+		std::cerr << "Error parsing options: " << e.what() << std::endl;
+		std::cerr << options.help() << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (result.count("help"))
+	{
+		std::cout << options.help() << std::endl;
+		return EXIT_SUCCESS;
+	}
+	if (result.count("batch"))
+	{
+		BatchOptions batch{};
+		batch.W = result.count("width") ? result["width"].as<uint32_t>() : 0;
+		batch.rotations = result["rotate"].as<bool>();
+		batch.strategy = static_cast<Heuristic>(std::clamp(result["strategy"].as<int>(), 0, static_cast<int>(Heuristic::Count)-1));
+		batch.all_heuristics = result["all"].as<bool>();
+		batch.output_dir = result.count("output") ? result["output"].as<std::string>() : "";
+		batch.on_result = [](const BatchEntry &entry)
+		{
+			if (entry.error.empty())
+				std::cout << "  > " << entry.path << ": height " << entry.result.h << " (optimal >= " << entry.result.opt_h
+						  << (entry.known_h != 0 ? ", known " + std::to_string(entry.known_h) : "") << ", Time: " << entry.result.elapsed_ms << "ms)\n";
+			else
+				std::cout << "  > " << entry.path << ": " << entry.error << '\n';
+		};
+
+		std::vector<std::string> files;
+		try
+		{
+			files = list_instances(result["batch"].as<std::string>());
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "Error: " << e.what() << '\n';
+			return EXIT_FAILURE;
+		}
+
+		std::cout << '\n'
+		<< "Solving a batch of " << files.size() << " instances..." << '\n';
+		std::cout << "> Rotations:       " << (batch.rotations ? "Yes" : "No") << '\n';
+		std::cout << "> Sort Strategy:   " << (batch.all_heuristics ? "All" : HeuristicStrings.at(batch.strategy)) << '\n';
+		std::cout << "> Output Folder:   " << (batch.output_dir.empty() ? "None" : batch.output_dir) << "\n\n";
+
+		BatchSummary summary = solve_batch(files, batch);
+		std::cout << "\nSolved " << summary.entries.size() - summary.failed << " of " << summary.entries.size() << " instances in " << summary.elapsed_ms << "ms\n";
+		if (!summary.summary_error.empty())
+			std::cerr << "Error: " << summary.summary_error << '\n';
+		return summary.failed == 0 && summary.summary_error.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if (result["stream"].as<bool>())
+	{
+		// The CSV may go to stdout, so messages go to stderr
+		std::ios::sync_with_stdio(false);
+		StreamOptions stream{};
+		stream.W = result.count("width") ? result["width"].as<uint32_t>() : 0;
+		stream.rotations = result["rotate"].as<bool>();
+		stream.strategy = static_cast<Heuristic>(std::clamp(result["strategy"].as<int>(), 0, static_cast<int>(Heuristic::Count)-1));
+		stream.window = result["window"].as<size_t>();
+		stream.seal_depth = result["seal-depth"].as<uint32_t>();
+		std::string input_file = result.count("input-file") ? result["input-file"].as<std::string>() : "-";
+		std::string output_file = result.count("output") ? result["output"].as<std::string>() : "-";
+		if (stream.W == 0)
+		{
+			std::cerr << "Error: --stream needs <width>, as in: packer --stream - <width>\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cerr << '\n'
+		<< "Streaming with:" << '\n';
+		std::cerr << "> Input:           " << (input_file == "-" ? "stdin" : input_file) << '\n';
+		std::cerr << "> Width:           " << stream.W << '\n';
+		std::cerr << "> Rotations:       " << (stream.rotations ? "Yes" : "No") << '\n';
+		std::cerr << "> Sort Strategy:   " << HeuristicStrings.at(stream.strategy) << " (window of " << stream.window << ")" << '\n';
+		std::cerr << "> Seal Depth:      " << (stream.seal_depth == 0 ? "4x tallest rectangle" : std::to_string(stream.seal_depth)) << '\n';
+		std::cerr << "> Output File:     " << (output_file == "-" ? "stdout" : output_file) << '\n';
+
+		StreamSummary summary{};
+		try
+		{
+			std::ifstream file;
+			if (input_file != "-")
+			{
+				file.open(input_file);
+				if (!file.is_open())
+					throw std::runtime_error("Couldn't open file " + input_file);
+			}
+			ResultWriter writer(output_file);
+			writer.write_columns();
+			stream.on_place = [&writer](const Shape &placed)
+			{ writer.write_rectangle(placed); };
+			summary = stream_pack(input_file == "-" ? std::cin : file, input_file == "-" ? "stdin" : input_file, stream);
+			writer.write_summary(summary.result);
+			writer.close();
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << '\n'
+					  << "Error: " << e.what() << '\n';
+			return EXIT_FAILURE;
+		}
+
+		const Result &packed = summary.result;
+		std::cerr << '\n'
+				  << "Result:" << '\n';
+		std::cerr << "> Rectangles:                   " << summary.placed << " (Time: " << packed.elapsed_ms << "ms)" << '\n';
+		std::cerr << "> Solution Height:              " << packed.h << '\n';
+		std::cerr << "> Theoretical Optimal Height:   " << packed.opt_h << '\n';
+		std::cerr << "> Loss:                         " << packed.loss << '%' << '\n';
+		std::cerr << "> Sealed Below:                 " << summary.frontier << '\n';
+		std::cerr << "> Most Holes / Rectangles Held: " << summary.peak_holes << " / " << summary.peak_rectangles << '\n';
+		return EXIT_SUCCESS;
+	}
+	if (result.count("input-file") == 0)
+	{
+		std::cerr << "Error: Missing required argument <rectangles_file>.\n";
+		std::cout << options.help() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Get Args from parsed results
+	std::string exe_path = argv[0];
+	std::string input_file = result["input-file"].as<std::string>();
+	bool rotations = result["rotate"].as<bool>();
+	bool verbose = result["verbose"].as<bool>();
+	auto strategy = static_cast<Heuristic>(std::clamp(result["strategy"].as<int>(), 0, static_cast<int>(Heuristic::Count)-1));
+	bool all_heuristics = result["all"].as<bool>();
+	bool multi_start = result["multi-start"].as<bool>();
+	bool local = result["local-search"].as<bool>();
+	bool exact = result["exact"].as<bool>();
+	double time_limit = result["time-limit"].as<double>();
+	uint64_t seed = result.count("seed") ? result["seed"].as<uint64_t>() : (uint64_t(std::random_device{}()) << 32 | std::random_device{}());
+
+	std::string output_file;
+	if (result.count("output"))
+	{
+		output_file = result["output"].as<std::string>();
+	}
+
+	// Reading input file, large text ones on all cores
+	Instance instance{};
+	try
+	{
+		ThreadPool pool{};
+		instance = load_instance(input_file, &pool);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << '\n'
+				  << "Error: " << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+	std::vector<Shape> &rectangles = instance.rectangles;
+
+	// <width> if given, else the instance's own
+	uint32_t W = result.count("width") ? result["width"].as<uint32_t>() : instance.W;
+	if (W == 0)
+	{
+		std::cerr << "Error: Missing required argument <width>, " << input_file << " doesn't give one.\n";
+		std::cout << options.help() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Streaming writes the rectangles while the solver places them
+	bool stream_output = result["stream-output"].as<bool>() && !output_file.empty() && !exact && !multi_start && !local && !all_heuristics;
+	std::unique_ptr<ResultWriter> writer;
+	try
+	{
+		if (!output_file.empty())
+			writer = std::make_unique<ResultWriter>(output_file);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "Error: " << e.what() << ".\n";
+	}
+
+	// Solve
+	Solver solver;
+	Result pack_result;
+	if (stream_output && writer)
+	{
+		writer->write_columns();
+		solver.set_on_place([&writer](const Shape &placed)
+							{ writer->write_rectangle(placed); });
+	}
+	if (exact)
+	{
+		ExactOptions search{};
+		search.time_limit = time_limit;
+		search.max_nodes = result["node-limit"].as<uint64_t>();
+		search.on_improvement = [](uint32_t best_h)
+		{ std::cout << "  > Best height " << best_h << '\n'; };
+		search.on_bound = [](uint32_t lower_bound)
+		{ std::cout << "  > No packing below " << lower_bound << '\n'; };
+
+		std::cout << '\n'
+		<< "Solving with branch-and-bound..." << '\n';
+		std::cout << "> Input File:      " << input_file << '\n';
+		std::cout << "> Width:           " << W << '\n';
+		std::cout << "> Rotations:       " << (rotations ? "Yes" : "No") << '\n';
+		std::cout << "> Time Limit:      " << search.time_limit << "s" << '\n';
+		std::cout << "> Node Limit:      " << (search.max_nodes == 0 ? "None" : std::to_string(search.max_nodes)) << '\n';
+		std::cout << "> Output File:     " << (output_file.empty() ? "None" : output_file) << "\n\n";
+
+		ExactResult found = solve_exact(W, rectangles, rotations, search);
+		pack_result = std::move(found.result);
+		std::cout << "\nExplored " << found.nodes << " nodes (" << found.steals << " stolen)\n";
+		if (found.optimal)
+			std::cout << "Proved optimal\n";
+		else
+			std::cout << "Stopped at a limit, gap " << pack_result.h - found.lower_bound << " (optimal height is in [" << found.lower_bound << ", " << pack_result.h << "])\n";
+	}
+	else if (multi_start)
+	{
+		MultiStartOptions search{};
+		search.time_limit = time_limit;
+		search.seed = seed;
+		search.on_improvement = [](uint32_t best_h, uint64_t start)
+		{ std::cout << "  > Best height " << best_h << " (start " << start << ")\n"; };
+
+		std::cout << '\n'
+		<< "Solving with randomized multi-start..." << '\n';
+		std::cout << "> Input File:      " << input_file << '\n';
+		std::cout << "> Width:           " << W << '\n';
+		std::cout << "> Rotations:       " << (rotations ? "Yes" : "No") << '\n';
+		std::cout << "> Time Limit:      " << search.time_limit << "s" << '\n';
+		std::cout << "> Seed:            " << search.seed << '\n';
+		std::cout << "> Output File:     " << (output_file.empty() ? "None" : output_file) << "\n\n";
+
+		pack_result = solve_multi_start(W, rectangles, rotations, search);
+		std::cout << "\nBest result found from strategy: \"" << HeuristicStrings.at(pack_result.sort_strategy) << "\"\n";
+	}
+	else if (local)
+	{
+		LocalSearchOptions search{};
+		search.time_limit = time_limit;
+		search.seed = seed;
+		search.on_improvement = [](uint32_t best_h, uint64_t move)
+		{ std::cout << "  > Best height " << best_h << " (move " << move << ")\n"; };
+
+		print_args(input_file, W, rotations, strategy, verbose, output_file);
+		std::cout << "> Local Search:    " << time_limit << "s, seed " << seed << "\n\n";
+		pack_result = local_search(W, rectangles, rotations, strategy, search);
+	}
+	else if (all_heuristics)
+	{
+		std::cout << '\n'
+		<< "Solving with all heuristics to find the best result..." << '\n';
+		std::cout << "> Input File:      " << input_file << '\n';
+		std::cout << "> Width:           " << W << '\n';
+		std::cout << "> Rotations:       " << (rotations ? "Yes" : "No") << '\n';
+		std::cout << "> Output File:     " << (output_file.empty() ? "None" : output_file) << "\n\n";
+
+		// Strategies run in parallel, their progress isn't shown
+		auto start = std::chrono::high_resolution_clock::now();
+		ThreadPool pool{};
+		std::vector<Result> results = solve_portfolio(W, rectangles, rotations, pool);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		for (const Result &current_result : results)
+		{
+			std::cout << "Testing Strategy: " << HeuristicStrings.at(current_result.sort_strategy) << " ...\n";
+			if (current_result.complete)
+				std::cout << "  > Result Height: " << current_result.h << " (Time: " << current_result.elapsed_ms << "ms)\n";
+			else
+				std::cout << "  > Stopped at height " << current_result.h << ", another strategy did as well or better (Time: " << current_result.elapsed_ms << "ms)\n";
+		}
+		pack_result = best_result(results);
+		std::cout << "\nAll strategies took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms";
+		std::cout << "\nBest result found using strategy: \"" << HeuristicStrings.at(pack_result.sort_strategy) << "\"\n";
+	}
+	else
+	{
+		print_args(input_file, W, rotations, strategy, verbose, output_file);
+		SolveCutoff cutoff{};
+		cutoff.lower_bound = height_lower_bound(W, rectangles, rotations).value;
+		pack_result = solver.solve(W, rectangles, rotations, strategy, verbose, cutoff);
+	}
+
+	print_result(pack_result);
+	if (instance.known_h != 0)
+		std::cout << "> Known Optimal Height:         " << instance.known_h << '\n';
+	if (verbose)
+	{
+		ThreadPool pool{};
+		print_bound(height_lower_bound(W, rectangles, rotations, &pool));
+	}
+
+	// Write to output file
+	if (writer)
+	{
+		try
+		{
+			if (stream_output)
+				writer->write_summary(pack_result);
+			else
+				writer->write(pack_result);
+			writer->close();
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "Error: " << e.what() << ".\n";
+		}
+	}
+
+	// Visualize result
+	visualize(pack_result, 1280, 720, get_font_path(exe_path));
+
+	return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -1,93 +1,136 @@
-/**==============================================
- * ?                    ABOUT
- * @author      : Romain BESSON
- * @description : Type/Class definitions for strip packing
- *=============================================**/
-
-#ifndef TYPES_H
-#define TYPES_H
-
-#include <map>
-#include <vector>
-#include <string>
-#include <chrono>
-#include <optional>
-#include <functional>
-
-/**============================================
- *          Shape class (x,y,w,h,...)
- *=============================================**/
-class Shape {
-private:
-	uint32_t id_ = 0;
-	uint32_t x_ = 0;
-	uint32_t y_ = 0;
-	uint32_t w_ = 0;
-	uint32_t h_ = 0;
-	mutable std::optional<uint32_t> area_;
-	bool is_rotated_ = false;
-
-public:
-	Shape(uint32_t id, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
-		: id_(id), x_(x), y_(y), w_(w), h_(h)
-	{}
-
-	uint32_t id() const { return id_; }
-	uint32_t x() const { return x_; }
-	uint32_t y() const { return y_; }
-	uint32_t w() const { return w_; }
-	uint32_t h() const { return h_; }
-	uint32_t x2() const { return x_ + w_; }
-	uint32_t y2() const { return y_ + h_; }
-	bool is_rotated() const { return is_rotated_; }
-	
-	// Mutators
-	uint32_t area() const; // stores calculated area in area_
-	void set_position(uint32_t new_x, uint32_t new_y) { x_ = new_x; y_ = new_y; }
-	void rotate();
-
-	// Geometric queries
-	bool fits_in(const Shape &container) const;
-	bool is_in(const Shape &container) const;
-	bool intersects(const Shape &other) const;
-	bool is_covered(const std::vector<Shape> &others) const;
-
-	bool operator==(const Shape &other) const;
-};
-
-/**============================================
- *         Sorting Strategy Heuristic
- *=============================================**/
-enum class Heuristic
-{
-	DescendingArea,
-	DescendingArea2,
-	DescendingWidth,
-	DescendingHeight,
-	
-	Count
-};
-
-const std::map<Heuristic, std::string> HeuristicStrings = {
-	{Heuristic::DescendingArea, "Descending Area"},
-	{Heuristic::DescendingArea2, "Descending Area 2"},
-	{Heuristic::DescendingWidth, "Descending Width"},
-	{Heuristic::DescendingHeight, "Descending Height"},
-};
-
-/**============================================
- *               Result structure
- * contains info on the result of the packing
- *=============================================**/
-struct Result
-{
-	uint32_t w = 0, h = 0;                               // Width & Height of container/canvas
-	uint32_t opt_h = 0;                                  // Theoretical Optimal Height -> opt_h = totalRectArea / w
-	Heuristic sort_strategy = Heuristic::DescendingArea; // Initial Sort Method used to sort rectangles
-	float loss = 0.0;                                    // Canvas loss as percentage -> loss = (containerArea - totalRectArea) / (containerArea);
-	bool rotations = false;                              // Were rotations allowed
-	std::vector<Shape> rectangles{};                     // vector with packed rects (x/y's changed) and sorted by ascending id
-	long long elapsed_ms{};
-};
-
-#endif
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Type/Class definitions for strip packing
+ *=============================================**/
+
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <optional>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/**============================================
+ *          Rect class (x,y,w,h)
+ * Plain 16-byte geometry record the packer works
+ * on, ids and rotation live next to it
+ *=============================================**/
+class Rect {
+private:
+	uint32_t x_ = 0;
+	uint32_t y_ = 0;
+	uint32_t w_ = 0;
+	uint32_t h_ = 0;
+
+public:
+	Rect() = default;
+	Rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+		: x_(x), y_(y), w_(w), h_(h)
+	{}
+
+	uint32_t x() const { return x_; }
+	uint32_t y() const { return y_; }
+	uint32_t w() const { return w_; }
+	uint32_t h() const { return h_; }
+	uint32_t x2() const { return x_ + w_; }
+	uint32_t y2() const { return y_ + h_; }
+	uint64_t area() const { return uint64_t(w_) * h_; }
+
+	// Mutators
+	void set_position(uint32_t new_x, uint32_t new_y) { x_ = new_x; y_ = new_y; }
+	void rotate() { std::swap(w_, h_); }
+
+	// Geometric queries
+	bool fits_in(const Rect &container) const;
+	bool is_in(const Rect &container) const;
+	bool intersects(const Rect &other) const;
+
+	bool operator==(const Rect &other) const;
+};
+
+static_assert(sizeof(Rect) == 16 && std::is_trivially_copyable_v<Rect>, "Rect must stay a 16-byte plain record");
+
+/**============================================
+ *          Shape class (x,y,w,h,...)
+ *=============================================**/
+class Shape {
+private:
+	uint32_t id_ = 0;
+	Rect rect_{};
+	bool is_rotated_ = false;
+
+public:
+	Shape(uint32_t id, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+		: id_(id), rect_(x, y, w, h)
+	{}
+	Shape(uint32_t id, const Rect &rect, bool is_rotated)
+		: id_(id), rect_(rect), is_rotated_(is_rotated)
+	{}
+
+	uint32_t id() const { return id_; }
+	uint32_t x() const { return rect_.x(); }
+	uint32_t y() const { return rect_.y(); }
+	uint32_t w() const { return rect_.w(); }
+	uint32_t h() const { return rect_.h(); }
+	uint32_t x2() const { return rect_.x2(); }
+	uint32_t y2() const { return rect_.y2(); }
+	uint64_t area() const { return rect_.area(); }
+	bool is_rotated() const { return is_rotated_; }
+	const Rect &rect() const { return rect_; }
+	
+	// Mutators
+	void set_position(uint32_t new_x, uint32_t new_y) { rect_.set_position(new_x, new_y); }
+	void rotate();
+
+	// Geometric queries
+	bool fits_in(const Shape &container) const { return rect_.fits_in(container.rect_); }
+	bool is_in(const Shape &container) const { return rect_.is_in(container.rect_); }
+	bool intersects(const Shape &other) const { return rect_.intersects(other.rect_); }
+	bool is_covered(const std::vector<Shape> &others) const;
+
+	bool operator==(const Shape &other) const { return rect_ == other.rect_; }
+};
+
+/**============================================
+ *         Sorting Strategy Heuristic
+ *=============================================**/
+enum class Heuristic
+{
+	DescendingArea,
+	DescendingArea2,
+	DescendingWidth,
+	DescendingHeight,
+	
+	Count
+};
+
+const std::map<Heuristic, std::string> HeuristicStrings = {
+	{Heuristic::DescendingArea, "Descending Area"},
+	{Heuristic::DescendingArea2, "Descending Area 2"},
+	{Heuristic::DescendingWidth, "Descending Width"},
+	{Heuristic::DescendingHeight, "Descending Height"},
+};
+
+/**============================================
+ *               Result structure
+ * contains info on the result of the packing
+ *=============================================**/
+struct Result
+{
+	uint32_t w = 0, h = 0;                               // Width & Height of container/canvas
+	uint32_t opt_h = 0;                                  // Theoretical Optimal Height -> opt_h = totalRectArea / w
+	Heuristic sort_strategy = Heuristic::DescendingArea; // Initial Sort Method used to sort rectangles
+	float loss = 0.0;                                    // Canvas loss as percentage -> loss = (containerArea - totalRectArea) / (containerArea);
+	bool rotations = false;                              // Were rotations allowed
+	std::vector<Shape> rectangles{};                     // vector with packed rects (x/y's changed) and sorted by ascending id
+	bool complete = true;                                // false if the solve stopped early, rectangles then only holds the placed ones and opt_h is 0
+	long long elapsed_ms{};
+};
+
+#endif
@@ -0,0 +1,81 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests that a reused Solver
+ *                allocates nothing
+ *=============================================**/
+
+#include <new>
+#include <atomic>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
+
+#include "test.h"
+#include "../src/packer/packer.h"
+#include "../src/packer/lower_bound.h"
+
+// Heap allocations made by the test binary so far
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *memory = std::malloc(size == 0 ? 1 : size))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, size_t) noexcept { std::free(memory); }
+
+namespace
+{
+
+bool same_placements(const Result &a, const Result &b)
+{
+	return a.h == b.h && a.opt_h == b.opt_h && a.complete == b.complete &&
+		   std::equal(a.rectangles.begin(), a.rectangles.end(), b.rectangles.begin(), b.rectangles.end(),
+					  [](const Shape &x, const Shape &y)
+					  { return x.id() == y.id() && x == y && x.is_rotated() == y.is_rotated(); });
+}
+
+} // namespace
+
+// Once a Solver and a Result have held an instance, solving it again with every
+// heuristic, both ways and in a given order, allocates nothing and packs as a new Solver
+TEST(reused_solver_allocates_nothing)
+{
+	std::mt19937 engine(3);
+	uint32_t W = 1000;
+	std::vector<Shape> rectangles;
+	for (uint32_t i = 1; i <= 2000; ++i)
+		rectangles.emplace_back(i, 0, 0, 1 + engine() % 100, 1 + engine() % 100);
+
+	SolveCutoff cutoff{};
+	cutoff.lower_bound = height_lower_bound(W, rectangles, false).value;
+	SolveCutoff rotated_cutoff{};
+	rotated_cutoff.lower_bound = height_lower_bound(W, rectangles, true).value;
+
+	Solver solver;
+	Result result;
+	for (uint32_t round = 0; round < 2; ++round)
+	{
+		uint64_t before = allocations.load();
+		for (bool rotations : {false, true})
+		{
+			const SolveCutoff &bound = rotations ? rotated_cutoff : cutoff;
+			for (uint32_t s = 0; s < static_cast<uint32_t>(Heuristic::Count); ++s)
+				solver.solve(result, W, rectangles, rotations, static_cast<Heuristic>(s), false, bound);
+			solver.solve_in_order(result, W, rectangles, rotations, Heuristic::DescendingArea, false, bound);
+		}
+		uint64_t made = allocations.load() - before;
+		CHECK(round == 0 ? made > 0 : made == 0);
+	}
+
+	for (uint32_t s = 0; s < static_cast<uint32_t>(Heuristic::Count); ++s)
+	{
+		solver.solve(result, W, rectangles, true, static_cast<Heuristic>(s), false, rotated_cutoff);
+		CHECK(same_placements(result, solve(W, rectangles, true, static_cast<Heuristic>(s), false)));
+	}
+}
@@ -0,0 +1,92 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the batch pipeline's
+ *                result files and summary
+ *=============================================**/
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+#include "test.h"
+#include "../src/packer/batch.h"
+
+namespace
+{
+
+// A directory in the temporary directory, removed with the TempDirectory
+struct TempDirectory
+{
+	std::filesystem::path path;
+
+	explicit TempDirectory(const std::string &name)
+		: path(std::filesystem::temp_directory_path() / ("batch_test_" + name))
+	{
+		std::filesystem::remove_all(path);
+		std::filesystem::create_directories(path);
+	}
+	~TempDirectory() { std::filesystem::remove_all(path); }
+
+	std::string write(const std::string &name, const std::string &bytes) const
+	{
+		std::filesystem::path file = path / name;
+		std::filesystem::create_directories(file.parent_path());
+		std::ofstream(file, std::ios::binary) << bytes;
+		return file.string();
+	}
+};
+
+std::string read(const std::filesystem::path &path)
+{
+	std::ifstream file(path);
+	std::stringstream bytes;
+	bytes << file.rdbuf();
+	return bytes.str();
+}
+
+} // namespace
+
+// Instances of the same name in different folders keep a result file each, one whose file
+// another instance already has fails, and the summary quotes fields holding separators
+TEST(batch_results_mirror_the_instance_folders)
+{
+	TempDirectory input("input");
+	TempDirectory output("output");
+	std::vector<std::string> files = {
+		input.write("a/x_W10.txt", "3 4\n5 6\n"),
+		input.write("a/x_W10.lst", "3 4\n"),
+		input.write("b/x_W10.txt", "10 1\n"),
+		input.write("b/c,\"d\"_W10.txt", "1 1\n"),
+		input.write("b/empty_W10.txt", ""),
+	};
+
+	BatchOptions options{};
+	options.solvers = 2;
+	options.output_dir = output.path.string();
+	BatchSummary summary = solve_batch(files, options);
+	CHECK(summary.summary_error.empty());
+	CHECK(summary.failed == 1 && !summary.entries[1].error.empty() && summary.entries[1].result.h == 0);
+	CHECK(std::filesystem::exists(output.path / "a" / "x_W10_result.csv"));
+	CHECK(std::filesystem::exists(output.path / "b" / "x_W10_result.csv"));
+	CHECK(summary.entries[0].result.h == 6 && summary.entries[2].result.h == 1);
+
+	std::string csv = read(output.path / "summary.csv");
+	CHECK(csv.find("\n\"" + files[3].substr(0, files[3].find('"')) + "\"\"d\"\"_W10.txt\",10,1,1,1,,1,") != std::string::npos);
+	CHECK(csv.find("\n" + files[4] + ",10,0,0,0,,,") != std::string::npos);
+}
+
+// A summary that can't be written is reported, the instances are still solved
+TEST(batch_reports_an_unwritable_summary)
+{
+	TempDirectory input("unwritable");
+	std::vector<std::string> files = {input.write("x_W10.txt", "3 4\n")};
+	std::string blocker = input.write("blocker", "");
+
+	BatchOptions options{};
+	options.solvers = 1;
+	options.output_dir = (std::filesystem::path(blocker) / "out").string();
+	BatchSummary summary = solve_batch(files, options);
+	CHECK(!summary.summary_error.empty());
+	CHECK(summary.entries.size() == 1 && summary.failed == 1);
+}
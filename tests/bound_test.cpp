@@ -0,0 +1,113 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the height lower bound
+ *                on instances of known height
+ *=============================================**/
+
+#include <random>
+#include <algorithm>
+#include <filesystem>
+
+#include "test.h"
+#include "../src/packer/lower_bound.h"
+#include "../src/packer/thread_pool.h"
+#include "../src/packer/loader.h"
+
+namespace
+{
+
+// Cuts a W by H rectangle into count pieces, each cut across a random piece: they pack back into H
+std::vector<Shape> guillotine_pieces(uint32_t W, uint32_t H, uint32_t count, std::mt19937 &engine)
+{
+	std::vector<Rect> pieces{Rect(0, 0, W, H)};
+	while (pieces.size() < count)
+	{
+		Rect &piece = pieces[engine() % pieces.size()];
+		bool across = engine() % 2 == 0;
+		uint32_t side = across ? piece.w() : piece.h();
+		if (side < 2)
+			continue;
+		uint32_t cut = 1 + engine() % (side - 1);
+		Rect rest = across ? Rect(piece.x() + cut, piece.y(), piece.w() - cut, piece.h())
+						   : Rect(piece.x(), piece.y() + cut, piece.w(), piece.h() - cut);
+		piece = across ? Rect(piece.x(), piece.y(), cut, piece.h()) : Rect(piece.x(), piece.y(), piece.w(), cut);
+		pieces.push_back(rest);
+	}
+
+	std::vector<Shape> rectangles;
+	for (uint32_t i = 0; i < pieces.size(); ++i)
+	{
+		rectangles.push_back(Shape(i + 1, 0, 0, pieces[i].w(), pieces[i].h()));
+	}
+	return rectangles;
+}
+
+// The area and tallest bounds worked out by hand
+uint32_t simple_bound(uint32_t W, const std::vector<Shape> &rectangles, bool rotations)
+{
+	uint64_t area = 0;
+	uint32_t tallest = 0;
+	for (const Shape &rectangle : rectangles)
+	{
+		area += uint64_t(rectangle.w()) * rectangle.h();
+		uint32_t h = rectangle.h();
+		if (rotations && rectangle.h() <= W)
+			h = std::min(h, rectangle.w());
+		tallest = std::max(tallest, h);
+	}
+	return std::max<uint32_t>((area + W - 1) / W, tallest);
+}
+
+} // namespace
+
+// No bound above the height the pieces came from, none below the simple ones, the same with a pool
+TEST(lower_bound_is_below_guillotine_heights)
+{
+	std::mt19937 engine(13);
+	ThreadPool pool(3);
+	for (uint32_t round = 0; round < 200; ++round)
+	{
+		uint32_t W = 10 + engine() % 200, H = 10 + engine() % 200;
+		std::vector<Shape> rectangles = guillotine_pieces(W, H, 2 + engine() % 60, engine);
+		for (bool rotations : {false, true})
+		{
+			HeightBound bound = height_lower_bound(W, rectangles, rotations);
+			CHECK(bound.value <= H);
+			CHECK(bound.value >= simple_bound(W, rectangles, rotations));
+			CHECK(!bound.bounds.empty());
+			for (const BoundStats &family : bound.bounds)
+				CHECK(family.value <= bound.value);
+			CHECK(height_lower_bound(W, rectangles, rotations, &pool).value == bound.value);
+		}
+	}
+}
+
+// The instances whose optimum is in their name: rotations only lower the optimum
+TEST(lower_bound_is_below_known_optima)
+{
+	size_t instances = 0;
+	for (const auto &file : std::filesystem::directory_iterator("instances_no_rotation/hopper"))
+	{
+		Instance instance = load_instance(file.path().string());
+		if (instance.known_h == 0)
+			continue;
+		instances++;
+		uint32_t fixed = height_lower_bound(instance.W, instance.rectangles, false).value;
+		uint32_t rotated = height_lower_bound(instance.W, instance.rectangles, true).value;
+		CHECK(fixed <= instance.known_h);
+		CHECK(rotated <= fixed);
+		CHECK(fixed >= simple_bound(instance.W, instance.rectangles, false));
+	}
+	CHECK(instances > 10);
+}
+
+// Heights of rectangles of one width add up past 32 bits without wrapping around
+TEST(lower_bound_sums_tall_rectangles)
+{
+	std::vector<Shape> rectangles;
+	for (uint32_t i = 1; i <= 8; ++i)
+		rectangles.emplace_back(i, 0, 0, 1, 1u << 30);
+	CHECK(height_lower_bound(4, rectangles, false).value == 1u << 31);
+	CHECK(height_lower_bound(4, rectangles, true).value == 1u << 31);
+}
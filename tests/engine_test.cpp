@@ -0,0 +1,235 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the packer against a
+ *                plain reference engine
+ *=============================================**/
+
+#include <random>
+#include <algorithm>
+
+#include "test.h"
+#include "../src/packer/packer.h"
+
+namespace
+{
+
+/**============================================
+ *              ReferenceEngine
+ * The baseline's packing rules on a plain
+ * vector, every query a linear scan: each cut
+ * hole split into its pieces (ids given in the
+ * order of the cut cases), a hole or piece inside
+ * a hole kept before it dropped, then the first
+ * pair of holes side by side (or on top of each
+ * other) in the list sorted by (y, x) merged
+ * until none is left, and the best hole picked
+ * the way the baseline did.
+ *=============================================**/
+struct ReferenceEngine
+{
+	struct Entry
+	{
+		Rect hole;
+		uint32_t id;
+	};
+
+	uint32_t W;
+	std::vector<Entry> holes{};
+	std::vector<Rect> placed{};
+	uint32_t next_id = 2;
+
+	explicit ReferenceEngine(uint32_t W) : W(W), holes{Entry{Rect(0, 0, W, 1000000000), 1}} {}
+
+	Rect place(uint32_t w, uint32_t h, bool rotations)
+	{
+		rotations = rotations && w != h;
+		uint32_t ws[2] = {w, h}, hs[2] = {h, w};
+		const Entry *best = nullptr;
+		bool best_rotated = false;
+		for (const Entry &entry : holes)
+		{
+			for (bool rotated : {false, true})
+			{
+				if ((rotated && !rotations) || ws[rotated] > entry.hole.w() || hs[rotated] > entry.hole.h())
+					continue;
+				if (best)
+				{
+					bool perfect = entry.hole.w() == ws[rotated] && entry.hole.h() == hs[rotated];
+					bool best_perfect = best->hole.w() == ws[rotated] && best->hole.h() == hs[rotated];
+					if (best_perfect && !perfect)
+						continue;
+					if (perfect == best_perfect &&
+						std::make_tuple(entry.hole.y() + hs[rotated], entry.hole.y(), entry.hole.x(), entry.hole.h(), entry.hole.w(), entry.id) >=
+							std::make_tuple(best->hole.y() + hs[best_rotated], best->hole.y(), best->hole.x(), best->hole.h(), best->hole.w(), best->id))
+						continue;
+				}
+				best = &entry;
+				best_rotated = rotated;
+			}
+		}
+
+		Rect hole = best->hole;
+		Rect rectangle(hole.x(), hole.y(), ws[best_rotated], hs[best_rotated]);
+		if (!supported(rectangle))
+			rectangle = Rect(hole.x2() - rectangle.w(), hole.y(), rectangle.w(), rectangle.h());
+		occupy(rectangle);
+		placed.push_back(rectangle);
+		return rectangle;
+	}
+
+	// More than half of the left edge touches placed rectangles, or one covers it all
+	bool supported(const Rect &rectangle) const
+	{
+		if (rectangle.x() == 0)
+			return true;
+		uint32_t supported_length = 0;
+		for (const Rect &other : placed)
+		{
+			if (other.x2() != rectangle.x() || other.y() >= rectangle.y2() || other.y2() <= rectangle.y())
+				continue;
+			if (other.y() <= rectangle.y() && other.y2() >= rectangle.y2())
+				return true;
+			supported_length += std::min(other.y2(), rectangle.y2()) - std::max(other.y(), rectangle.y());
+		}
+		return supported_length > rectangle.h() * 0.5f;
+	}
+
+	void occupy(const Rect &rectangle)
+	{
+		enum Side
+		{
+			LEFT,
+			TOP,
+			RIGHT,
+			BOTTOM
+		};
+		static const std::vector<Side> cases[16] = {
+			{}, {LEFT}, {TOP}, {TOP, LEFT}, {RIGHT}, {LEFT, RIGHT}, {TOP, RIGHT}, {LEFT, TOP, RIGHT}, {BOTTOM}, {LEFT, BOTTOM}, {TOP, BOTTOM}, {TOP, LEFT, BOTTOM}, {BOTTOM, RIGHT}, {LEFT, BOTTOM, RIGHT}, {TOP, RIGHT, BOTTOM}, {TOP, LEFT, RIGHT, BOTTOM}};
+
+		std::vector<Entry> next;
+		auto covered = [&next](const Rect &hole)
+		{ return std::any_of(next.begin(), next.end(), [&hole](const Entry &other)
+							 { return hole.is_in(other.hole); }); };
+		for (const Entry &entry : holes)
+		{
+			const Rect &hole = entry.hole;
+			if (!hole.intersects(rectangle))
+			{
+				if (!covered(hole))
+					next.push_back(entry);
+				continue;
+			}
+			uint32_t code = (rectangle.x() > hole.x() ? 1 : 0) | (rectangle.y() > hole.y() ? 2 : 0) |
+							(rectangle.x2() < hole.x2() ? 4 : 0) | (rectangle.y2() < hole.y2() ? 8 : 0);
+			std::vector<Entry> pieces;
+			for (Side side : cases[code])
+			{
+				Rect piece = side == LEFT	? Rect(hole.x(), hole.y(), rectangle.x() - hole.x(), hole.h())
+							 : side == TOP	? Rect(hole.x(), hole.y(), hole.w(), rectangle.y() - hole.y())
+							 : side == RIGHT ? Rect(rectangle.x2(), hole.y(), hole.x2() - rectangle.x2(), hole.h())
+											 : Rect(hole.x(), rectangle.y2(), hole.w(), hole.y2() - rectangle.y2());
+				pieces.push_back(Entry{piece, next_id++});
+			}
+			if (covered(hole))
+				continue;
+			for (const Entry &piece : pieces)
+			{
+				if (!covered(piece.hole))
+					next.push_back(piece);
+			}
+		}
+
+		for (bool merged = true; merged;)
+		{
+			merged = false;
+			std::sort(next.begin(), next.end(), [](const Entry &a, const Entry &b)
+					  { return std::make_pair(a.hole.y(), a.hole.x()) < std::make_pair(b.hole.y(), b.hole.x()); });
+			for (size_t i = 0; i < next.size() && !merged; ++i)
+			{
+				for (size_t j = i + 1; j < next.size() && !merged; ++j)
+				{
+					const Rect a = next[i].hole, b = next[j].hole;
+					if (a.y() == b.y() && a.h() == b.h() && a.x2() == b.x())
+						next[i].hole = Rect(a.x(), a.y(), a.w() + b.w(), a.h());
+					else if (a.x() == b.x() && a.w() == b.w() && a.y2() == b.y())
+						next[i].hole = Rect(a.x(), a.y(), a.w(), a.h() + b.h());
+					else
+						continue;
+					next.erase(next.begin() + j);
+					merged = true;
+				}
+			}
+		}
+		holes = std::move(next);
+	}
+};
+
+bool same_holes(const Packer &packer, const ReferenceEngine &reference)
+{
+	std::vector<Rect> holes(packer.holes().begin(), packer.holes().end());
+	return std::equal(holes.begin(), holes.end(), reference.holes.begin(), reference.holes.end(),
+					  [](const Rect &a, const ReferenceEngine::Entry &b)
+					  { return a == b.hole; });
+}
+
+} // namespace
+
+// Enough rectangles that the hole count crosses the indexing thresholds both ways
+TEST(packer_matches_the_reference_engine)
+{
+	for (uint32_t seed = 1; seed <= 3; ++seed)
+	{
+		std::mt19937 engine(seed);
+		bool rotations = seed != 2;
+		uint32_t W = 300;
+		Packer packer(W);
+		ReferenceEngine reference(W);
+		size_t peak = 0;
+		for (uint32_t i = 0; i < 1200; ++i)
+		{
+			// Small rectangles make many holes, the wide ones in between close them again
+			bool wide = i % 300 >= 250;
+			uint32_t w = wide ? 100 + engine() % 200 : 1 + engine() % 40;
+			uint32_t h = 1 + engine() % 40;
+			Rect placed = packer.place(w, h, rotations).rect();
+			CHECK(placed == reference.place(w, h, rotations));
+			peak = std::max(peak, packer.holes().size());
+			if (i % 50 == 0)
+				CHECK(same_holes(packer, reference));
+		}
+		CHECK(same_holes(packer, reference));
+		CHECK(peak > 600);
+	}
+}
+
+// A restored Packer goes on like the one it was saved from
+TEST(restored_packer_matches_the_reference_engine)
+{
+	std::mt19937 engine(11);
+	Packer packer(300);
+	ReferenceEngine reference(300);
+	for (uint32_t i = 0; i < 600; ++i)
+	{
+		uint32_t w = 1 + engine() % 25, h = 1 + engine() % 40;
+		CHECK(packer.place(w, h, true).rect() == reference.place(w, h, true));
+	}
+	PackerCheckpoint checkpoint = packer.checkpoint();
+	ReferenceEngine saved = reference;
+
+	for (uint32_t i = 0; i < 200; ++i)
+	{
+		uint32_t w = 1 + engine() % 25, h = 1 + engine() % 40;
+		CHECK(packer.place(w, h, true).rect() == reference.place(w, h, true));
+	}
+
+	Packer fork(checkpoint);
+	CHECK(same_holes(fork, saved));
+	for (uint32_t i = 0; i < 200; ++i)
+	{
+		uint32_t w = 1 + engine() % 25, h = 1 + engine() % 40;
+		CHECK(fork.place(w, h, true).rect() == saved.place(w, h, true));
+	}
+	CHECK(same_holes(fork, saved));
+	CHECK(same_holes(packer, reference));
+}
@@ -0,0 +1,113 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the exact solver on
+ *                instances of known height
+ *=============================================**/
+
+#include <random>
+#include <algorithm>
+
+#include "test.h"
+#include "../src/packer/exact.h"
+
+namespace
+{
+
+// Cuts a W by H rectangle into count pieces, each cut across a random piece: the pieces pack
+// back into height H, and no packing is lower
+std::vector<Shape> guillotine_pieces(uint32_t W, uint32_t H, uint32_t count, uint32_t seed)
+{
+	std::mt19937 engine(seed);
+	std::vector<Rect> pieces{Rect(0, 0, W, H)};
+	while (pieces.size() < count)
+	{
+		Rect &piece = pieces[engine() % pieces.size()];
+		bool across = engine() % 2 == 0;
+		uint32_t side = across ? piece.w() : piece.h();
+		if (side < 2)
+			continue;
+		uint32_t cut = 1 + engine() % (side - 1);
+		Rect rest = across ? Rect(piece.x() + cut, piece.y(), piece.w() - cut, piece.h())
+						   : Rect(piece.x(), piece.y() + cut, piece.w(), piece.h() - cut);
+		piece = across ? Rect(piece.x(), piece.y(), cut, piece.h()) : Rect(piece.x(), piece.y(), piece.w(), cut);
+		pieces.push_back(rest);
+	}
+
+	std::vector<Shape> rectangles;
+	for (uint32_t i = 0; i < pieces.size(); ++i)
+	{
+		rectangles.push_back(Shape(i + 1, 0, 0, pieces[i].w(), pieces[i].h()));
+	}
+	return rectangles;
+}
+
+// Every input placed once, at its size, in the strip, without overlaps, and result.h is the top
+bool valid_result(const Result &result, uint32_t W, const std::vector<Shape> &rectangles)
+{
+	if (result.rectangles.size() != rectangles.size())
+		return false;
+	uint32_t top = 0;
+	for (size_t i = 0; i < result.rectangles.size(); ++i)
+	{
+		const Shape &placed = result.rectangles[i];
+		const Shape &input = rectangles[placed.id() - 1];
+		bool same_size = (placed.w() == input.w() && placed.h() == input.h()) || (placed.w() == input.h() && placed.h() == input.w());
+		if (placed.id() != i + 1 || !same_size || placed.x2() > W)
+			return false;
+		for (size_t j = i + 1; j < result.rectangles.size(); ++j)
+		{
+			if (placed.intersects(result.rectangles[j]))
+				return false;
+		}
+		top = std::max(top, placed.y2());
+	}
+	return top == result.h;
+}
+
+} // namespace
+
+// Most of these the heuristics already pack to the bound, some need a search
+TEST(exact_packs_guillotine_cuts_back_to_their_height)
+{
+	uint64_t nodes = 0;
+	for (uint32_t count : {9, 12, 14})
+	{
+		for (uint32_t seed = 1; seed <= 6; ++seed)
+		{
+			uint32_t W = 12, H = 10;
+			std::vector<Shape> rectangles = guillotine_pieces(W, H, count, seed);
+			for (bool rotations : {false, true})
+			{
+				ExactOptions options{};
+				options.threads = 1 + seed % 3;
+				ExactResult exact = solve_exact(W, rectangles, rotations, options);
+				CHECK(exact.optimal);
+				CHECK(exact.result.h == H && exact.lower_bound == H);
+				CHECK(valid_result(exact.result, W, rectangles));
+				nodes += exact.nodes;
+			}
+		}
+	}
+	CHECK(nodes > 1000);
+}
+
+// The area bound is 4, but the two squares can't share a row
+TEST(exact_proves_heights_above_the_area_bound)
+{
+	std::vector<Shape> rectangles{Shape(1, 0, 0, 3, 3), Shape(2, 0, 0, 3, 3), Shape(3, 0, 0, 2, 1)};
+	for (size_t threads : {1, 2})
+	{
+		ExactOptions options{};
+		options.threads = threads;
+		ExactResult exact = solve_exact(5, rectangles, true, options);
+		CHECK(exact.optimal);
+		CHECK(exact.result.h == 6 && exact.lower_bound == 6);
+		CHECK(valid_result(exact.result, 5, rectangles));
+	}
+
+	// Side by side once the strip is wide enough
+	ExactResult wide = solve_exact(6, rectangles, false, ExactOptions{});
+	CHECK(wide.optimal && wide.result.h == 4);
+	CHECK(valid_result(wide.result, 6, rectangles));
+}
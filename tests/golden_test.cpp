@@ -0,0 +1,86 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Packings of the corpus against
+ *                those of the original engine
+ *=============================================**/
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "test.h"
+#include "../src/packer/packer.h"
+#include "../src/packer/loader.h"
+
+namespace
+{
+
+// FNV-1a of (id, x, y, w, h) of each placed rectangle, by id
+uint64_t placement_hash(std::vector<Shape> rectangles)
+{
+	std::sort(rectangles.begin(), rectangles.end(), [](const Shape &a, const Shape &b)
+			  { return a.id() < b.id(); });
+	uint64_t hash = 14695981039346656037ULL;
+	for (const Shape &rectangle : rectangles)
+	{
+		for (uint32_t value : {rectangle.id(), rectangle.x(), rectangle.y(), rectangle.w(), rectangle.h()})
+		{
+			hash ^= value;
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+// "<height> <hash>" of a packing, as the golden file has it, "- -" if solve throws
+std::string packing(const Instance &instance, bool rotations, Heuristic strategy)
+{
+	try
+	{
+		Result result = solve(instance.W, instance.rectangles, rotations, strategy, false);
+		std::ostringstream out;
+		out << result.h << ' ' << std::hex << std::setw(16) << std::setfill('0') << placement_hash(result.rectangles);
+		return out.str();
+	}
+	catch (const std::runtime_error &)
+	{
+		return "- -";
+	}
+}
+
+} // namespace
+
+// tests/corpus_golden.txt has a line "<instance> <rotations> <heuristic> <height> <hash>" for
+// each instance of the corpus, both ways and with each heuristic, as packed by the engine
+// before the hole indexes (fcd297e). The packer must place every rectangle where it did
+TEST(corpus_packings_match_the_original_engine)
+{
+	std::ifstream golden("tests/corpus_golden.txt");
+	CHECK(golden.is_open());
+
+	std::string line, path, loaded_path;
+	Instance instance;
+	uint32_t cases = 0;
+	while (std::getline(golden, line))
+	{
+		std::istringstream fields(line);
+		int rotations, strategy;
+		std::string expected;
+		fields >> path >> rotations >> strategy;
+		std::getline(fields >> std::ws, expected);
+		if (path != loaded_path)
+		{
+			instance = load_instance(path);
+			loaded_path = path;
+		}
+
+		std::string packed = packing(instance, rotations != 0, static_cast<Heuristic>(strategy));
+		if (packed != expected)
+			std::cout << "    " << line << ": packed " << packed << '\n';
+		CHECK(packed == expected);
+		cases++;
+	}
+	CHECK(cases == 592);
+}
@@ -0,0 +1,170 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the hole set against
+ *                a brute force grid
+ *=============================================**/
+
+#include <random>
+#include <algorithm>
+
+#include "test.h"
+#include "../src/packer/packer.h"
+
+/**============================================
+ *                 FreeGrid
+ * Unit cells of the strip up to height, marked
+ * used by the placed rectangles and the fills.
+ * Its maximal free rectangles are what the hole
+ * set must hold, rows at height and above are
+ * free, so a rectangle reaching height is open.
+ *=============================================**/
+struct FreeGrid
+{
+	uint32_t W, height;
+	std::vector<uint32_t> used{}; // Prefix sums of used cells, (W + 1) by (height + 1)
+
+	FreeGrid(uint32_t W, uint32_t height, const std::vector<Rect> &areas) : W(W), height(height), used((W + 1) * (height + 1), 0)
+	{
+		std::vector<uint8_t> cells(W * height, 0);
+		for (const Rect &area : areas)
+		{
+			for (uint32_t y = area.y(); y < area.y2(); ++y)
+				for (uint32_t x = area.x(); x < area.x2(); ++x)
+					cells[y * W + x] = 1;
+		}
+		for (uint32_t y = 0; y < height; ++y)
+			for (uint32_t x = 0; x < W; ++x)
+				at(x + 1, y + 1) = cells[y * W + x] + at(x, y + 1) + at(x + 1, y) - at(x, y);
+	}
+
+	uint32_t &at(uint32_t x, uint32_t y) { return used[y * (W + 1) + x]; }
+	uint32_t at(uint32_t x, uint32_t y) const { return used[y * (W + 1) + x]; }
+
+	bool free(uint32_t x, uint32_t y, uint32_t x2, uint32_t y2) const
+	{
+		return at(x2, y2) - at(x, y2) - at(x2, y) + at(x, y) == 0;
+	}
+
+	// Maximal free rectangles, open ones reach height
+	std::vector<Rect> maximal() const
+	{
+		std::vector<Rect> rects;
+		for (uint32_t y = 0; y < height; ++y)
+			for (uint32_t x = 0; x < W; ++x)
+				for (uint32_t x2 = x + 1; x2 <= W && free(x, y, x2, y + 1); ++x2)
+					for (uint32_t y2 = y + 1; y2 <= height && free(x, y, x2, y2); ++y2)
+					{
+						bool grows = (x > 0 && free(x - 1, y, x2, y2)) || (y > 0 && free(x, y - 1, x2, y2)) ||
+									 (x2 < W && free(x, y, x2 + 1, y2)) || (y2 < height && free(x, y, x2, y2 + 1));
+						if (!grows)
+							rects.emplace_back(x, y, x2 - x, y2 - y);
+					}
+		return rects;
+	}
+};
+
+// Packs random rectangles, with a few fills, and checks the holes after each step
+static void check_random_packing(uint32_t W, uint32_t count, bool rotations, uint32_t seed)
+{
+	std::mt19937 engine(seed);
+	std::uniform_int_distribution<uint32_t> side(1, W / 2);
+	Packer packer(W);
+	std::vector<Rect> used;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (engine() % 8 == 0)
+		{
+			// Waste the corner of the first hole
+			Rect hole = packer.holes().front();
+			Rect area(hole.x(), hole.y(), 1, 1);
+			packer.fill(area);
+			used.push_back(area);
+		}
+		else
+		{
+			used.push_back(packer.place(side(engine), side(engine), rotations).rect());
+		}
+
+		// Rows past the packing are free, open holes end far above it
+		FreeGrid grid(W, packer.height() + 1, used);
+		std::vector<Rect> holes(packer.holes().begin(), packer.holes().end());
+		for (const Rect &free : grid.maximal())
+		{
+			bool open = free.y2() == grid.height;
+			CHECK(std::any_of(holes.begin(), holes.end(), [&free, open](const Rect &hole)
+							  { return hole.x() == free.x() && hole.y() == free.y() && hole.w() == free.w() &&
+									   (open ? hole.y2() > free.y2() : hole.y2() == free.y2()); }));
+		}
+
+		// Holes are free and none can merge with another
+		for (size_t a = 0; a < holes.size(); ++a)
+		{
+			uint32_t y2 = std::min(holes[a].y2(), grid.height);
+			CHECK(holes[a].x2() <= W && grid.free(holes[a].x(), holes[a].y(), holes[a].x2(), y2));
+			for (size_t b = 0; b < holes.size(); ++b)
+			{
+				if (a == b)
+					continue;
+				bool side_by_side = holes[a].y() == holes[b].y() && holes[a].h() == holes[b].h() && holes[a].x2() == holes[b].x();
+				bool stacked = holes[a].x() == holes[b].x() && holes[a].w() == holes[b].w() && holes[a].y2() == holes[b].y();
+				CHECK(!side_by_side && !stacked);
+			}
+		}
+	}
+}
+
+TEST(holes_are_the_maximal_free_rectangles)
+{
+	for (uint32_t seed = 1; seed <= 20; ++seed)
+	{
+		check_random_packing(8, 12, false, seed);
+		check_random_packing(11, 12, true, seed);
+	}
+}
+
+TEST(holes_are_in_y_x_order)
+{
+	Packer packer(20);
+	std::mt19937 engine(7);
+	for (uint32_t i = 0; i < 200; ++i)
+	{
+		packer.place(1 + engine() % 7, 1 + engine() % 7, true);
+		std::vector<Rect> holes(packer.holes().begin(), packer.holes().end());
+		CHECK(std::is_sorted(holes.begin(), holes.end(), [](const Rect &a, const Rect &b)
+							 { return std::make_pair(a.y(), a.x()) < std::make_pair(b.y(), b.x()); }));
+	}
+}
+
+// A rectangle in a closed 10 by 6 hole, each of its edges inside the hole's or on it, one
+// case per bit of code. The pieces left are the ones the cut keeps, in (y, x) order, the
+// left and top pieces sharing the hole's corner in the order the baseline cut made them
+TEST(cut_leaves_a_piece_per_edge_inside_the_hole)
+{
+	for (uint32_t code = 0; code < 16; ++code)
+	{
+		Packer packer(10);
+		packer.fill(Rect(0, 6, 10, 1));
+		uint32_t x = code & 1 ? 3 : 0, y = code & 2 ? 2 : 0;
+		uint32_t x2 = code & 4 ? 7 : 10, y2 = code & 8 ? 4 : 6;
+		packer.place_at(x, y, x2 - x, y2 - y, false);
+
+		std::vector<Rect> expected;
+		Rect left(0, 0, x, 6), top(0, 0, 10, y);
+		if (code == 7)
+			std::swap(left, top);
+		if (top.w() > 0 && top.h() > 0)
+			expected.push_back(top);
+		if (left.w() > 0 && left.h() > 0)
+			expected.push_back(left);
+		if (x2 < 10)
+			expected.push_back(Rect(x2, 0, 10 - x2, 6));
+		if (y2 < 6)
+			expected.push_back(Rect(0, y2, 10, 6 - y2));
+
+		std::vector<Rect> holes(packer.holes().begin(), packer.holes().end());
+		CHECK(holes.size() == expected.size() + 1 && holes.back().y() == 7);
+		holes.pop_back();
+		CHECK(holes == expected);
+	}
+}
@@ -0,0 +1,205 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the hole arrays and the
+ *                hole indexes against linear scans
+ *=============================================**/
+
+#include <random>
+#include <algorithm>
+
+#include "test.h"
+#include "../src/packer/hole_arrays.h"
+#include "../src/packer/dominance_index.h"
+#include "../src/packer/edge_index.h"
+
+namespace
+{
+
+struct Entry
+{
+	Rect hole;
+	uint32_t id;
+};
+
+Rect random_rect(std::mt19937 &engine, uint32_t range)
+{
+	return Rect(engine() % range, engine() % range, 1 + engine() % range, 1 + engine() % range);
+}
+
+} // namespace
+
+// Sorted random holes, some erased, every query checked against a scan of the holes left
+TEST(hole_arrays_match_a_linear_scan)
+{
+	std::mt19937 engine(3);
+	HoleArrays arrays;
+	for (uint32_t round = 0; round < 200; ++round)
+	{
+		// Sizes on both sides of a lane and of a power of two of blocks
+		std::vector<Rect> holes(engine() % 300);
+		for (Rect &hole : holes)
+		{
+			hole = random_rect(engine, 200);
+		}
+		std::sort(holes.begin(), holes.end(), [](const Rect &a, const Rect &b)
+				  { return std::make_pair(a.y(), a.x()) < std::make_pair(b.y(), b.x()); });
+		arrays.build(holes);
+		CHECK(arrays.size() == holes.size());
+
+		std::vector<uint8_t> erased(holes.size(), 0);
+		for (size_t pos = 0; pos < holes.size(); ++pos)
+		{
+			if (engine() % 4 == 0)
+			{
+				arrays.erase(pos);
+				erased[pos] = 1;
+			}
+		}
+
+		for (uint32_t query = 0; query < 20; ++query)
+		{
+			uint32_t w = 1 + engine() % 200, h = 1 + engine() % 200;
+			size_t from = engine() % (holes.size() + 1);
+			size_t found = from;
+			while (found < holes.size() && (erased[found] || holes[found].w() < w || holes[found].h() < h))
+				found++;
+			CHECK(arrays.first_fitting(from, w, h) == (found < holes.size() ? found : HoleArrays::NONE));
+
+			Rect area = random_rect(engine, 150);
+			std::vector<size_t> intersecting, containing, expected_intersecting, expected_containing;
+			arrays.for_each_intersecting(area, [&intersecting](size_t pos)
+										 { intersecting.push_back(pos); return false; });
+			arrays.for_each_containing(area, [&containing](size_t pos)
+									   { containing.push_back(pos); return false; });
+			for (size_t pos = 0; pos < holes.size(); ++pos)
+			{
+				if (erased[pos])
+					continue;
+				if (holes[pos].intersects(area))
+					expected_intersecting.push_back(pos);
+				if (area.is_in(holes[pos]))
+					expected_containing.push_back(pos);
+			}
+			CHECK(intersecting == expected_intersecting);
+			CHECK(containing == expected_containing);
+		}
+	}
+}
+
+TEST(dominance_index_matches_a_linear_scan)
+{
+	std::mt19937 engine(5);
+	DominanceIndex index;
+	std::vector<Entry> live;
+	uint32_t next_id = 1;
+	for (uint32_t step = 0; step < 20000; ++step)
+	{
+		bool grow = (step / 5000) % 2 == 0;
+		if (live.empty() || engine() % 100 < (grow ? 70u : 30u))
+		{
+			Entry entry{random_rect(engine, 100), next_id++};
+			index.insert(entry.id, entry.hole);
+			live.push_back(entry);
+		}
+		else
+		{
+			size_t pos = engine() % live.size();
+			index.remove(live[pos].id);
+			live[pos] = live.back();
+			live.pop_back();
+		}
+
+		if (step % 53 != 0)
+			continue;
+		CHECK(index.size() == live.size());
+		Rect query = random_rect(engine, 60);
+		std::vector<uint32_t> found, expected;
+		index.for_each_containing(query, [&found](uint32_t id, const Rect &)
+								  { found.push_back(id); return false; });
+		for (const Entry &entry : live)
+		{
+			if (query.is_in(entry.hole))
+				expected.push_back(entry.id);
+		}
+		std::sort(found.begin(), found.end());
+		std::sort(expected.begin(), expected.end());
+		CHECK(found == expected);
+		CHECK(index.any_containing(query) == !expected.empty());
+
+		Rect area = random_rect(engine, 100);
+		found.clear();
+		expected.clear();
+		index.for_each_inside(area, [&found](uint32_t id, const Rect &)
+							  { found.push_back(id); return false; });
+		for (const Entry &entry : live)
+		{
+			if (entry.hole.is_in(area))
+				expected.push_back(entry.id);
+		}
+		std::sort(found.begin(), found.end());
+		std::sort(expected.begin(), expected.end());
+		CHECK(found == expected);
+	}
+}
+
+// Holes on a coarse grid, so many share edges, each edge query checked against a scan
+TEST(edge_index_matches_a_linear_scan)
+{
+	std::mt19937 engine(11);
+	Arena arena;
+	EdgeIndex index(arena);
+	std::vector<Entry> live;
+	uint32_t next_id = 1;
+	auto grid_rect = [&engine]()
+	{ return Rect(engine() % 6 * 10, engine() % 6 * 10, (1 + engine() % 3) * 10, (1 + engine() % 3) * 10); };
+	for (uint32_t step = 0; step < 5000; ++step)
+	{
+		if (live.empty() || engine() % 100 < 60)
+		{
+			Entry entry{grid_rect(), next_id++};
+			index.insert(entry.id, entry.hole);
+			live.push_back(entry);
+		}
+		else
+		{
+			size_t pos = engine() % live.size();
+			index.remove(live[pos].id, live[pos].hole);
+			live[pos] = live.back();
+			live.pop_back();
+		}
+
+		if (step % 37 != 0)
+			continue;
+		Rect hole = grid_rect();
+		std::vector<uint32_t> found[4], expected[4];
+		auto collect = [](std::vector<uint32_t> &ids)
+		{ return [&ids](uint32_t id, const Rect &)
+		  { ids.push_back(id); return false; }; };
+		index.for_each_right_of(hole, collect(found[0]));
+		index.for_each_left_of(hole, collect(found[1]));
+		index.for_each_below(hole, collect(found[2]));
+		index.for_each_above(hole, collect(found[3]));
+		for (const Entry &entry : live)
+		{
+			const Rect &other = entry.hole;
+			if (other.x() == hole.x2() && other.y() == hole.y() && other.h() == hole.h())
+				expected[0].push_back(entry.id);
+			if (other.x2() == hole.x() && other.y() == hole.y() && other.h() == hole.h())
+				expected[1].push_back(entry.id);
+			if (other.y() == hole.y2() && other.x() == hole.x() && other.w() == hole.w())
+				expected[2].push_back(entry.id);
+			if (other.y2() == hole.y() && other.x() == hole.x() && other.w() == hole.w())
+				expected[3].push_back(entry.id);
+		}
+		for (uint32_t side = 0; side < 4; ++side)
+		{
+			std::sort(found[side].begin(), found[side].end());
+			std::sort(expected[side].begin(), expected[side].end());
+			CHECK(found[side] == expected[side]);
+		}
+		const Entry &entry = live[engine() % live.size()];
+		CHECK(index.contains(entry.id, entry.hole));
+		CHECK(!index.contains(entry.id, Rect(entry.hole.x(), entry.hole.y(), entry.hole.w() + 1, entry.hole.h())));
+	}
+}
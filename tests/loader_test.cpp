@@ -0,0 +1,208 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the instance loader
+ *                and its file formats
+ *=============================================**/
+
+#include <random>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#include "test.h"
+#include "../src/packer/loader.h"
+#include "../src/packer/thread_pool.h"
+
+namespace
+{
+
+// Writes bytes to a file named name in the temporary directory, removed with the TempFile
+struct TempFile
+{
+	std::string path;
+
+	TempFile(const std::string &name, const std::string &bytes)
+		: path((std::filesystem::temp_directory_path() / ("loader_test_" + name)).string())
+	{
+		std::ofstream(path, std::ios::binary) << bytes;
+	}
+	~TempFile() { std::filesystem::remove(path); }
+};
+
+bool same_rectangles(const std::vector<Shape> &a, const std::vector<Shape> &b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Shape &x, const Shape &y)
+					  { return x.id() == y.id() && x.w() == y.w() && x.h() == y.h(); });
+}
+
+std::vector<Shape> parse(const std::string &text, ThreadPool *pool = nullptr)
+{
+	return parse_rectangles(text.data(), text.data() + text.size(), "text", pool);
+}
+
+// The message parse throws on text, empty if it doesn't throw
+std::string parse_error(const std::string &text)
+{
+	try
+	{
+		parse(text);
+	}
+	catch (const std::exception &error)
+	{
+		return error.what();
+	}
+	return "";
+}
+
+} // namespace
+
+// Blanks, tabs, commas, CRLF line ends, blank lines and a last line without its newline
+TEST(parse_reads_rectangle_lines)
+{
+	std::vector<Shape> rectangles = parse("3 4\n\n  10\t20 \r\n7,8\n\t\n5 , 6\r\n1 2");
+	std::vector<Shape> expected{Shape(1, 0, 0, 3, 4), Shape(2, 0, 0, 10, 20), Shape(3, 0, 0, 7, 8),
+								Shape(4, 0, 0, 5, 6), Shape(5, 0, 0, 1, 2)};
+	CHECK(same_rectangles(rectangles, expected));
+	CHECK(parse("").empty() && parse("\n \r\n").empty());
+}
+
+TEST(parse_throws_on_malformed_lines)
+{
+	for (const char *bad : {"3", "3 x", "3 4 5", "-3 4", "3.5 4", "3 4x", "99999999999 4", ",3 4", "3,,4"})
+	{
+		CHECK(parse_error(std::string("1 2\n\n") + bad + "\n5 6\n").find("line 3 of text") != std::string::npos);
+	}
+	std::istringstream in("1 2\n3\n");
+	CHECK_THROWS(read_rectangles(in, "in", [](const Shape &) {}));
+	CHECK_THROWS(load_rectangles("no/such/file.txt"));
+}
+
+// Enough text for the pool to parse it in chunks, read back from a file and from a stream
+TEST(chunked_and_streamed_parses_match)
+{
+	std::mt19937 engine(17);
+	std::string text;
+	while (text.size() < (5 << 20))
+	{
+		text += std::to_string(1 + engine() % 100000) + (engine() % 2 ? " " : ",") + std::to_string(1 + engine() % 100000) + "\n";
+	}
+	std::vector<Shape> serial = parse(text);
+	ThreadPool pool(4);
+	CHECK(serial.size() > 300000);
+	CHECK(same_rectangles(parse(text, &pool), serial));
+
+	TempFile file("chunked.txt", text);
+	CHECK(same_rectangles(load_rectangles(file.path, &pool), serial));
+
+	std::vector<Shape> streamed;
+	std::istringstream in(text);
+	read_rectangles(in, "in", [&streamed](const Shape &rectangle)
+					{ streamed.push_back(rectangle); });
+	CHECK(same_rectangles(streamed, serial));
+
+	// A bad line far in is still named by its line number
+	text += "1 2\nbad\n";
+	CHECK(parse_error(text).find("line " + std::to_string(serial.size() + 2)) != std::string::npos);
+	CHECK_THROWS(parse(text, &pool));
+}
+
+// Written then mapped back, through BinaryInstance and load_instance; bad headers and short files throw
+TEST(binary_instances_round_trip)
+{
+	std::mt19937 engine(19);
+	std::vector<Shape> rectangles;
+	for (uint32_t i = 0; i < 1000; ++i)
+	{
+		rectangles.push_back(Shape(i + 1, 0, 0, 1 + engine() % 500, 1 + engine() % 500));
+	}
+	std::ostringstream os;
+	write_binary_instance(os, 600, rectangles, 321);
+	std::string bytes = os.str();
+	CHECK(bytes.size() == sizeof(BinaryHeader) + 8 * rectangles.size());
+
+	TempFile file("round_trip.bin", bytes);
+	BinaryInstance binary(file.path);
+	CHECK(binary.header().W == 600 && binary.header().known_h == 321 && binary.header().N == 1000);
+	CHECK(binary.w(999) == rectangles[999].w() && binary.h(999) == rectangles[999].h());
+	CHECK(same_rectangles(binary.rectangles(), rectangles));
+	Instance instance = load_instance(file.path);
+	CHECK(instance.W == 600 && instance.known_h == 321 && instance.problem == 0);
+	CHECK(same_rectangles(instance.rectangles, rectangles));
+
+	std::ostringstream empty;
+	write_binary_instance(empty, 10, {});
+	TempFile empty_file("empty.bin", empty.str());
+	CHECK(load_instance(empty_file.path).rectangles.empty() && load_instance(empty_file.path).known_h == 0);
+
+	std::string version = bytes;
+	version[4] = 2;
+	TempFile short_file("short.bin", bytes.substr(0, bytes.size() - 4)), version_file("version.bin", version), text_file("text.bin", "1 2\n");
+	CHECK_THROWS(BinaryInstance(short_file.path));
+	CHECK_THROWS(load_instance(short_file.path));
+	CHECK_THROWS(BinaryInstance(version_file.path));
+	CHECK_THROWS(BinaryInstance(text_file.path));
+	CHECK(load_instance(text_file.path).rectangles.size() == 1);
+}
+
+TEST(names_give_width_and_optimum)
+{
+	CHECK(width_from_name("dir/gcut1_W250.txt") == 250 && optimum_from_name("dir/gcut1_W250.txt") == 0);
+	CHECK(width_from_name("10_W60_OPTH90.txt") == 60 && optimum_from_name("10_W60_OPTH90.txt") == 90);
+	CHECK(optimum_from_name("c1_W20_OPT20.txt") == 20 && width_from_name("beng1_W25.lst") == 25);
+	CHECK(width_from_name("a_W12x_W30.txt") == 30 && width_from_name("W30.txt") == 0 && width_from_name("a_W.txt") == 0);
+	CHECK(width_from_name("dir_W40/a.txt") == 0);
+	CHECK(split_problem("orlib.txt:3") == std::make_pair(std::string("orlib.txt"), 3u));
+	CHECK(split_problem("orlib.txt") == std::make_pair(std::string("orlib.txt"), 0u));
+	CHECK(split_problem("c:/orlib.txt") == std::make_pair(std::string("c:/orlib.txt"), 0u));
+}
+
+// Files of the corpus in each layout
+TEST(corpus_files_load_natively)
+{
+	Instance gcut = load_instance("instances_no_rotation/beasley/gcut1_W250.txt");
+	CHECK(gcut.W == 250 && gcut.known_h == 0 && gcut.rectangles.size() == 10);
+
+	// ngcut: W on the first line, then <h>,<w> lines with CRLF ends
+	Instance ngcut = load_instance("instances_no_rotation/beasley/ngcut12.txt");
+	CHECK(ngcut.W == 30 && ngcut.rectangles.size() == 23);
+	CHECK(ngcut.rectangles.front().w() == 2 && ngcut.rectangles.front().h() == 22);
+	CHECK(ngcut.rectangles.back().w() == 13 && ngcut.rectangles.back().h() == 16);
+
+	Instance beng = load_instance("instances_no_rotation/beng/beng1_W25.lst");
+	CHECK(beng.W == 25 && beng.rectangles.size() == 20);
+	CHECK(beng.rectangles.front().w() == 8 && beng.rectangles.front().h() == 6);
+
+	Instance hopper = load_instance("instances_no_rotation/hopper/10_W60_OPTH60.txt");
+	CHECK(hopper.W == 60 && hopper.known_h == 60);
+	uint64_t area = 0;
+	for (const Shape &rectangle : hopper.rectangles)
+		area += uint64_t(rectangle.w()) * rectangle.h();
+	CHECK(area == 60 * 60);
+}
+
+// OR-Lib: two problems, each its own instance; text that stops following the layout is ngcut
+TEST(orlib_files_hold_a_problem_each)
+{
+	TempFile file("orlib.txt", "2\n1\n10 20\n2\n3 4 0 0 2\n5 6 1 1 1\n\n1\n8 9\n1\n2 3 0 0 3\n");
+	std::vector<Instance> problems = load_instances(file.path);
+	CHECK(problems.size() == 2);
+	CHECK(problems[0].problem == 1 && problems[0].W == 10 && problems[0].known_h == 20);
+	CHECK(same_rectangles(problems[0].rectangles, {Shape(1, 0, 0, 3, 4), Shape(2, 0, 0, 3, 4), Shape(3, 0, 0, 5, 6)}));
+	Instance second = load_instance(file.path + ":2");
+	CHECK(second.problem == 2 && second.W == 8 && second.known_h == 9 && second.rectangles.size() == 3);
+	CHECK(instance_paths(file.path) == std::vector<std::string>({file.path + ":1", file.path + ":2"}));
+	CHECK_THROWS(load_instance(file.path));
+	CHECK_THROWS(load_instance(file.path + ":3"));
+
+	TempFile ngcut("not_orlib.txt", "2\n1 5\n");
+	Instance instance = load_instance(ngcut.path);
+	CHECK(instance.W == 2 && same_rectangles(instance.rectangles, {Shape(1, 0, 0, 5, 1)}));
+	CHECK(instance_paths(ngcut.path) == std::vector<std::string>({ngcut.path}));
+
+	TempFile bad("bad_ngcut.txt", "10\n1 2\n3\n");
+	CHECK_THROWS(load_instance(bad.path));
+	CHECK_THROWS(load_instance("no/such/file.txt"));
+}
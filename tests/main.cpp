@@ -0,0 +1,39 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Runs the registered tests
+ *=============================================**/
+
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+#include "test.h"
+
+// Usage: tests [name filter]
+int main(int argc, char **argv)
+{
+	const char *filter = argc > 1 ? argv[1] : "";
+	uint32_t run = 0, failed = 0;
+	for (const TestCase &test : test_cases())
+	{
+		if (std::strstr(test.name, filter) == nullptr)
+			continue;
+		uint64_t before = test_failures();
+		std::cout << "> " << test.name << '\n';
+		try
+		{
+			test.run();
+		}
+		catch (const std::exception &e)
+		{
+			test_failures()++;
+			std::cout << "    threw: " << e.what() << '\n';
+		}
+		run++;
+		if (test_failures() != before)
+			failed++;
+	}
+	std::cout << "> " << run - failed << "/" << run << " tests passed\n";
+	return failed == 0 ? 0 : 1;
+}
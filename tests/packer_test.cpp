@@ -0,0 +1,259 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of the online Packer
+ *=============================================**/
+
+#include "test.h"
+#include "../src/packer/packer.h"
+
+// Holes stay in the strip, off the placed rectangles and none inside another
+static bool holes_are_valid(const Packer &packer)
+{
+	std::vector<Rect> holes(packer.holes().begin(), packer.holes().end());
+	for (const Rect &hole : holes)
+	{
+		if (hole.x2() > packer.width())
+			return false;
+		for (const Shape &rectangle : packer.rectangles())
+		{
+			if (hole.intersects(rectangle.rect()))
+				return false;
+		}
+	}
+	for (size_t i = 0; i < holes.size(); ++i)
+	{
+		for (size_t j = 0; j < holes.size(); ++j)
+		{
+			if (i != j && holes[i].is_in(holes[j]))
+				return false;
+		}
+	}
+	return true;
+}
+
+TEST(place_at_strictly_inside_a_hole)
+{
+	Packer packer(10);
+	packer.place_at(2, 2, 2, 2, false);
+	CHECK(packer.holes().size() == 4);
+	CHECK(holes_are_valid(packer));
+
+	// The strip is still open on every side of the rectangle
+	Shape next = packer.place(10, 2, false);
+	CHECK(next.x() == 0 && next.y() == 0);
+	CHECK(holes_are_valid(packer));
+}
+
+TEST(fill_strictly_inside_a_hole)
+{
+	Packer packer(10);
+	packer.fill(Rect(3, 5, 4, 1));
+	CHECK(packer.holes().size() == 4);
+	CHECK(packer.rectangles().size() == 0);
+
+	Shape next = packer.place(3, 5, false);
+	CHECK(next.x() == 0 && next.y() == 0);
+}
+
+TEST(place_at_and_fill_need_a_free_area)
+{
+	Packer packer(10);
+	packer.place_at(0, 0, 5, 5, false);
+	CHECK_THROWS(packer.place_at(4, 4, 2, 2, false));
+	CHECK_THROWS(packer.fill(Rect(0, 0, 1, 1)));
+	CHECK_THROWS(packer.place_at(8, 0, 3, 1, false));
+	CHECK(packer.rectangles().size() == 1);
+
+	packer.place_at(5, 0, 5, 5, false);
+	packer.fill(Rect(0, 5, 10, 1));
+	CHECK(packer.holes().size() == 1);
+	CHECK(packer.holes().front() == Rect(0, 6, 10, packer.holes().front().h()));
+}
+
+// Leaves holes (0, 0, 6, 5), (6, 5, 4, 3) and open ones from y = 9 in a strip 10 wide
+static void fill_around_a_perfect_fit(Packer &packer)
+{
+	packer.fill(Rect(6, 0, 4, 5));
+	packer.fill(Rect(0, 8, 10, 1));
+	packer.fill(Rect(0, 5, 6, 3));
+}
+
+TEST(a_perfect_fit_wins_over_a_lower_placement)
+{
+	Packer packer(10);
+	fill_around_a_perfect_fit(packer);
+	CHECK(packer.holes()[0] == Rect(0, 0, 6, 5) && packer.holes()[1] == Rect(6, 5, 4, 3) && packer.holes()[2].y() == 9);
+	Shape placed = packer.place(4, 3, false);
+	CHECK(placed.rect() == Rect(6, 5, 4, 3));
+
+	// A perfect fit only when rotated still wins over the lower placements of either orientation
+	Packer rotating(10);
+	fill_around_a_perfect_fit(rotating);
+	placed = rotating.place(3, 4, true);
+	CHECK(placed.rect() == Rect(6, 5, 4, 3) && placed.is_rotated());
+
+	// Without rotations it goes in the lowest hole
+	Packer upright(10);
+	fill_around_a_perfect_fit(upright);
+	CHECK(upright.place(3, 4, false).rect() == Rect(0, 0, 3, 4));
+}
+
+// A rectangle goes to the left of its hole if more than half its left edge touches placed
+// rectangles (or fills), else to the right of it
+TEST(left_support_picks_the_side_of_the_hole)
+{
+	Packer supported(10);
+	supported.place_at(0, 0, 2, 2, false);
+	CHECK(supported.place(3, 3, false).rect() == Rect(2, 0, 3, 3));
+
+	Packer unsupported(10);
+	unsupported.place_at(0, 0, 2, 1, false);
+	CHECK(unsupported.place(3, 3, false).rect() == Rect(7, 0, 3, 3));
+
+	// Exactly half is not enough, one neighbor covering it all is
+	Packer half(10);
+	half.place_at(0, 0, 2, 1, false);
+	CHECK(half.place(3, 2, false).rect() == Rect(7, 0, 3, 2));
+	Packer covered(10);
+	covered.fill(Rect(0, 0, 2, 5));
+	CHECK(covered.place(3, 2, false).rect() == Rect(2, 0, 3, 2));
+
+	// Two neighbors adding up to more than half
+	Packer two(10);
+	two.place_at(0, 0, 2, 1, false);
+	two.place_at(0, 2, 2, 1, false);
+	two.fill(Rect(0, 1, 1, 1));
+	CHECK(two.place(3, 3, false).rect() == Rect(2, 0, 3, 3));
+}
+
+// The bound counts a rectangle that may turn in its lower orientation fitting the strip
+TEST(stats_bound_the_height_from_below)
+{
+	Packer packer(10);
+	packer.place(20, 3, true);
+	CHECK(packer.stats().simple_bound == 20);
+	packer.place(2, 5, true);
+	CHECK(packer.stats().simple_bound == 20);
+
+	Packer flat(10);
+	flat.place(4, 2, true);
+	flat.place(10, 3, false);
+	CHECK(flat.stats().simple_bound == 4 && flat.stats().total_area == 38);
+}
+
+// Holes with their ids, in order
+static std::vector<std::pair<uint32_t, Rect>> hole_entries(const Packer &packer)
+{
+	std::vector<std::pair<uint32_t, Rect>> entries;
+	const std::vector<uint32_t> &ids = *packer.checkpoint().hole_ids;
+	for (size_t i = 0; i < ids.size(); ++i)
+	{
+		entries.emplace_back(ids[i], packer.holes()[i]);
+	}
+	return entries;
+}
+
+// Undoing goes back through the same states as restoring the checkpoints taken on the way,
+// past the hole count where the packer starts indexing the holes
+TEST(undo_takes_back_placements_and_fills)
+{
+	Packer packer(300);
+	packer.keep_undo(true);
+	std::vector<PackerCheckpoint> checkpoints;
+	size_t peak = 0;
+	uint32_t seed = 1;
+	auto next = [&seed](uint32_t range)
+	{
+		seed = seed * 1103515245 + 12345;
+		return 1 + (seed >> 16) % range;
+	};
+	for (uint32_t i = 0; i < 1500; ++i)
+	{
+		checkpoints.push_back(packer.checkpoint());
+		if (i % 7 == 3)
+		{
+			const Rect corner = packer.holes().front();
+			packer.fill(Rect(corner.x(), corner.y(), 1, 1));
+		}
+		else
+		{
+			packer.place(next(40), next(40), true);
+		}
+		peak = std::max(peak, packer.holes().size());
+	}
+	CHECK(peak > 512);
+
+	while (!checkpoints.empty())
+	{
+		packer.undo();
+		Packer expected(checkpoints.back());
+		checkpoints.pop_back();
+		CHECK(hole_entries(packer) == hole_entries(expected));
+		CHECK(packer.rectangles().size() == expected.rectangles().size());
+		CHECK(packer.stats().total_area == expected.stats().total_area && packer.height() == expected.height());
+
+		// The packer places the next rectangle where the restored one does
+		if (checkpoints.size() % 100 == 0)
+		{
+			uint32_t w = next(40), h = next(40);
+			CHECK(packer.place(w, h, true) == expected.place(w, h, true));
+			packer.undo();
+		}
+	}
+	CHECK_THROWS(packer.undo());
+}
+
+// Forks of one checkpoint, and the Packer it came from, go their own ways: each ends where
+// packing its rectangles from scratch does, and the checkpoint doesn't change
+TEST(checkpoints_are_shared_by_independent_forks)
+{
+	uint32_t seed = 5;
+	auto next = [&seed](uint32_t range)
+	{
+		seed = seed * 1103515245 + 12345;
+		return 1 + (seed >> 16) % range;
+	};
+	std::vector<std::pair<uint32_t, uint32_t>> prefix, sizes[3];
+	for (uint32_t i = 0; i < 300; ++i)
+		prefix.emplace_back(next(30), next(30));
+	for (auto &branch : sizes)
+		for (uint32_t i = 0; i < 200; ++i)
+			branch.emplace_back(next(30), next(30));
+
+	auto pack = [](Packer &packer, const std::vector<std::pair<uint32_t, uint32_t>> &rectangles)
+	{
+		for (const auto &size : rectangles)
+			packer.place(size.first, size.second, true);
+	};
+	auto same = [](const Packer &a, const Packer &b)
+	{
+		return hole_entries(a) == hole_entries(b) && a.height() == b.height() &&
+			   std::equal(a.rectangles().begin(), a.rectangles().end(), b.rectangles().begin(), b.rectangles().end(),
+						  [](const Shape &x, const Shape &y)
+						  { return x.id() == y.id() && x == y && x.is_rotated() == y.is_rotated(); });
+	};
+
+	Packer packer(200);
+	pack(packer, prefix);
+	PackerCheckpoint checkpoint = packer.checkpoint();
+	Packer saved(checkpoint);
+
+	Packer first(checkpoint);
+	Packer second(50); // Restored over a packing of another strip
+	second.place(10, 10, false);
+	second.restore(checkpoint);
+	pack(packer, sizes[0]);
+	pack(first, sizes[1]);
+	pack(second, sizes[2]);
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		Packer replay(200);
+		pack(replay, prefix);
+		pack(replay, sizes[i]);
+		CHECK(same(i == 0 ? packer : i == 1 ? first : second, replay));
+	}
+	CHECK(same(Packer(checkpoint), saved));
+	CHECK(Packer(checkpoint).stats().placed == 300);
+}
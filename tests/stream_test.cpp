@@ -0,0 +1,142 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Tests of sealing and of the
+ *                streaming packer
+ *=============================================**/
+
+#include <random>
+#include <sstream>
+#include <algorithm>
+
+#include "test.h"
+#include "../src/packer/packer.h"
+#include "../src/packer/stream.h"
+
+namespace
+{
+
+// Holes of packer sealed at frontier, worked out from its holes before the seal: the parts
+// above frontier of the holes across it go first among the holes at frontier with their x,
+// and a part inside another of those (or equal to an earlier one) goes
+std::vector<Rect> sealed_holes(const Packer &packer, uint32_t frontier)
+{
+	std::vector<Rect> row, above;
+	for (const Rect &hole : packer.holes())
+	{
+		if (hole.y() < frontier && hole.y2() > frontier)
+			row.emplace_back(hole.x(), frontier, hole.w(), hole.y2() - frontier);
+	}
+	size_t parts = row.size();
+	for (const Rect &hole : packer.holes())
+	{
+		if (hole.y() == frontier)
+			row.push_back(hole);
+		else if (hole.y() > frontier)
+			above.push_back(hole);
+	}
+	std::vector<bool> is_part(row.size(), false);
+	std::fill(is_part.begin(), is_part.begin() + parts, true);
+	std::vector<size_t> order(row.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&row](size_t a, size_t b)
+					 { return row[a].x() < row[b].x(); });
+
+	std::vector<Rect> holes;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const Rect &hole = row[order[i]];
+		bool covered = false;
+		for (size_t j = 0; j < order.size() && is_part[order[i]]; ++j)
+		{
+			covered = covered || (j != i && hole.is_in(row[order[j]]) && (!(hole == row[order[j]]) || j < i));
+		}
+		if (!covered)
+			holes.push_back(hole);
+	}
+	holes.insert(holes.end(), above.begin(), above.end());
+	return holes;
+}
+
+// No two rectangles overlap, all are in the strip and each id went out once
+bool valid_packing(const std::vector<Shape> &placed, uint32_t W)
+{
+	std::vector<Shape> sorted = placed;
+	std::sort(sorted.begin(), sorted.end(), [](const Shape &a, const Shape &b)
+			  { return a.y() < b.y(); });
+	uint32_t tallest = 0;
+	std::vector<uint32_t> seen(placed.size() + 1, 0);
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		if (sorted[i].x2() > W || sorted[i].id() == 0 || sorted[i].id() > placed.size() || seen[sorted[i].id()]++ != 0)
+			return false;
+		tallest = std::max(tallest, sorted[i].h());
+		for (size_t j = i + 1; j < sorted.size() && sorted[j].y() < sorted[i].y() + tallest; ++j)
+		{
+			if (sorted[i].intersects(sorted[j]))
+				return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+// Many seals, enough that hole ids get renumbered, each compared to the holes clipped by hand
+TEST(seal_clips_the_holes_at_the_frontier)
+{
+	std::mt19937 engine(7);
+	Packer packer(200);
+	for (uint32_t round = 0; round < 60; ++round)
+	{
+		for (uint32_t i = 0; i < 50; ++i)
+		{
+			Shape placed = packer.place(1 + engine() % 30, 1 + engine() % 30, true);
+			CHECK(placed.y() >= packer.frontier());
+		}
+		uint32_t frontier = packer.height() > 60 ? packer.height() - 60 : 0;
+		std::vector<Rect> expected = frontier > packer.frontier() ? sealed_holes(packer, frontier) : std::vector<Rect>(packer.holes().begin(), packer.holes().end());
+		packer.seal(frontier);
+		std::vector<Rect> holes(packer.holes().begin(), packer.holes().end());
+		CHECK(holes == expected);
+	}
+	CHECK(packer.frontier() > 0);
+	CHECK(packer.stats().placed == 3000);
+	CHECK(packer.rectangles().size() < 1500);
+}
+
+// A sealed stream packs every rectangle once, without overlaps, holding fewer holes
+TEST(stream_pack_seals_as_it_goes)
+{
+	std::mt19937 engine(9);
+	std::ostringstream feed;
+	for (uint32_t i = 0; i < 4000; ++i)
+	{
+		feed << 1 + engine() % 40 << " " << 1 + engine() % 40 << "\n";
+	}
+
+	auto run = [&feed](uint32_t seal_depth, std::vector<Shape> &placed)
+	{
+		std::istringstream in(feed.str());
+		StreamOptions options{};
+		options.W = 300;
+		options.window = 64;
+		options.seal_depth = seal_depth;
+		options.on_place = [&placed](const Shape &shape)
+		{ placed.push_back(shape); };
+		return stream_pack(in, "feed", options);
+	};
+
+	std::vector<Shape> sealed_placed, open_placed;
+	StreamSummary sealed = run(0, sealed_placed);
+	StreamSummary open = run(UINT32_MAX, open_placed);
+	CHECK(sealed.placed == 4000 && sealed_placed.size() == 4000);
+	CHECK(valid_packing(sealed_placed, 300));
+	CHECK(valid_packing(open_placed, 300));
+	CHECK(sealed.frontier > 0 && open.frontier == 0);
+	CHECK(sealed.peak_holes * 2 < open.peak_holes);
+	CHECK(sealed.peak_rectangles * 2 < open.peak_rectangles);
+}
@@ -0,0 +1,79 @@
+/**==============================================
+ * ?                    ABOUT
+ * @author      : Romain BESSON
+ * @description : Minimal test registry and checks
+ *=============================================**/
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+/**============================================
+ *                  Tests
+ * TEST(name) { ... } registers a test that the
+ * runner (main.cpp) calls in file order. A failed
+ * CHECK prints where it failed and the test goes
+ * on, CHECK_THROWS checks that an expression
+ * throws. The runner exits with 1 if any check
+ * failed.
+ *=============================================**/
+struct TestCase
+{
+	const char *name;
+	void (*run)();
+};
+
+inline std::vector<TestCase> &test_cases()
+{
+	static std::vector<TestCase> cases;
+	return cases;
+}
+
+inline uint64_t &test_failures()
+{
+	static uint64_t failures = 0;
+	return failures;
+}
+
+struct TestRegistrar
+{
+	TestRegistrar(const char *name, void (*run)())
+	{
+		test_cases().push_back(TestCase{name, run});
+	}
+};
+
+inline void test_check(bool passed, const char *what, const char *file, int line)
+{
+	if (passed)
+		return;
+	test_failures()++;
+	std::cout << "    " << file << ":" << line << ": CHECK(" << what << ") failed\n";
+}
+
+#define TEST(name)                                            \
+	static void name();                                       \
+	static TestRegistrar name##_registrar(#name, name);       \
+	static void name()
+
+#define CHECK(condition) test_check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_THROWS(expression)                                           \
+	do                                                                     \
+	{                                                                      \
+		bool thrown = false;                                               \
+		try                                                                \
+		{                                                                  \
+			(void)(expression);                                            \
+		}                                                                  \
+		catch (const std::exception &)                                     \
+		{                                                                  \
+			thrown = true;                                                 \
+		}                                                                  \
+		test_check(thrown, #expression " throws", __FILE__, __LINE__);     \
+	} while (false)
+
+#endif